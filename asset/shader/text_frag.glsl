@@ -0,0 +1,81 @@
+#version 300 es
+precision mediump float;
+
+in vec2  v_UV;
+in vec4  v_Color;
+in float v_Texure;
+
+out vec4 FragColor;
+
+uniform sampler2D u_Textures[16];
+
+// Bitmap atlases hold coverage; distance-field atlases hold the distance to the outline.
+uniform int   u_DistanceField;
+
+uniform vec4  u_OutlineColor;
+uniform float u_OutlineWidth;
+uniform vec4  u_ShadowColor;
+uniform vec2  u_ShadowOffset;
+
+// Font atlases are single channel, so everything is read from red.
+float SampleAtlas(vec2 uv)
+{
+    float value = 0.0;
+    switch(int(v_Texure))
+	{
+		case 0: value = texture(u_Textures[0], uv).r; break;
+		case 1: value = texture(u_Textures[1], uv).r; break;
+		case 2: value = texture(u_Textures[2], uv).r; break;
+		case 3: value = texture(u_Textures[3], uv).r; break;
+		case 4: value = texture(u_Textures[4], uv).r; break;
+		case 5: value = texture(u_Textures[5], uv).r; break;
+		case 6: value = texture(u_Textures[6], uv).r; break;
+		case 7: value = texture(u_Textures[7], uv).r; break;
+		case 8: value = texture(u_Textures[8], uv).r; break;
+		case 9: value = texture(u_Textures[9], uv).r; break;
+		case 10: value = texture(u_Textures[10], uv).r; break;
+		case 11: value = texture(u_Textures[11], uv).r; break;
+		case 12: value = texture(u_Textures[12], uv).r; break;
+		case 13: value = texture(u_Textures[13], uv).r; break;
+		case 14: value = texture(u_Textures[14], uv).r; break;
+		case 15: value = texture(u_Textures[15], uv).r; break;
+	}
+    return value;
+}
+
+// Distance-field value at uv, zero on the glyph edge and positive inside.
+float SampleDistance(vec2 uv)
+{
+    return SampleAtlas(uv) - 128.0 / 255.0;
+}
+
+// Measures the distance in screen pixels so the edge stays one pixel soft at any scale.
+float Coverage(float distance, float grow)
+{
+    float pixel = max(length(vec2(dFdx(distance), dFdy(distance))), 0.0001);
+    return clamp(distance / pixel + grow + 0.5, 0.0, 1.0);
+}
+
+void main()
+{
+    if(u_DistanceField == 0)
+    {
+        FragColor = vec4(v_Color.rgb, v_Color.a * SampleAtlas(v_UV));
+        return;
+    }
+
+    float distance = SampleDistance(v_UV);
+    float fill = Coverage(distance, 0.0);
+    float outline = Coverage(distance, u_OutlineWidth);
+    vec4 outline_color = u_OutlineWidth > 0.0 ? u_OutlineColor : v_Color;
+    vec4 glyph = mix(outline_color, v_Color, fill);
+    glyph.a *= outline;
+
+    // The shadow offset is in screen pixels, y down.
+    vec2 shadow_uv = v_UV - u_ShadowOffset.x * dFdx(v_UV) + u_ShadowOffset.y * dFdy(v_UV);
+    float shadow = Coverage(SampleDistance(shadow_uv), u_OutlineWidth) * u_ShadowColor.a;
+
+    float alpha = glyph.a + shadow * (1.0 - glyph.a);
+    vec3 color = (glyph.rgb * glyph.a + u_ShadowColor.rgb * shadow * (1.0 - glyph.a)) / max(alpha, 0.0001);
+    FragColor = vec4(color, alpha);
+}
\ No newline at end of file
@@ -0,0 +1,452 @@
+#include "AllocationTracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_assert.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <malloc.h>
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define ISKER_HAVE_BACKTRACE
+#endif
+
+// Frames of the tracker itself at the top of every captured stack.
+static const int SKIPPED_FRAMES = 2;
+static const int REPORTED_CALL_SITES = 10;
+
+// Everything the hooks touch is constant initialized, so allocations made
+// before main or after it returns are counted too.
+struct alignas(64) ThreadCounts
+{
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    char name[32] = {};
+};
+static ThreadCounts s_Threads[AllocationTracker::MAX_THREADS];
+static std::atomic<int> s_ThreadCount{ 0 };
+
+struct CallSite
+{
+    uint64_t hash;
+    void *frames[AllocationTracker::STACK_DEPTH];
+    int depth;
+    uint64_t allocations;
+    uint64_t bytes;
+    // The last frame the site allocated in, and how often it did then.
+    uint64_t lastFrame;
+    uint64_t frameAllocations;
+    bool reported;
+};
+static CallSite s_CallSites[AllocationTracker::MAX_CALL_SITES];
+static std::mutex s_CallSiteMutex;
+static uint64_t s_DroppedSamples = 0;
+
+static std::atomic<uint32_t> s_SampleInterval{ AllocationTracker::DEFAULT_SAMPLE_INTERVAL };
+static std::atomic<bool> s_SampleAll{ false };
+static std::atomic<uint64_t> s_Frame{ 0 };
+
+static thread_local int s_Slot = -1;
+static thread_local uint32_t s_UntilSample = 0;
+// Set while the tracker allocates for itself, so it neither counts nor samples that.
+static thread_local bool s_Suspended = false;
+// Depth of live Exemption scopes on this thread.
+static thread_local int s_Exempt = 0;
+
+static ThreadCounts &GetThreadCounts()
+{
+    if(s_Slot < 0)
+    {
+        // Threads past the limit share the last slot.
+        s_Slot = std::min(s_ThreadCount.fetch_add(1, std::memory_order_relaxed), AllocationTracker::MAX_THREADS - 1);
+        if(!s_Threads[s_Slot].name[0])
+            snprintf(s_Threads[s_Slot].name, sizeof(s_Threads[s_Slot].name), s_Slot == AllocationTracker::MAX_THREADS - 1 ? "Other" : "Thread %d", s_Slot);
+    }
+    return s_Threads[s_Slot];
+}
+
+static int CaptureStack(void **frames)
+{
+#if defined(_WIN32)
+    return CaptureStackBackTrace(SKIPPED_FRAMES, AllocationTracker::STACK_DEPTH, frames, nullptr);
+#elif defined(ISKER_HAVE_BACKTRACE)
+    void *stack[AllocationTracker::STACK_DEPTH + SKIPPED_FRAMES];
+    const int depth = backtrace(stack, AllocationTracker::STACK_DEPTH + SKIPPED_FRAMES) - SKIPPED_FRAMES;
+    if(depth <= 0) return 0;
+    memcpy(frames, stack + SKIPPED_FRAMES, depth * sizeof(void *));
+    return depth;
+#else
+    // No stack walking on the web; every sample lands in one unnamed site.
+    return 0;
+#endif
+}
+
+static void RecordSample(size_t bytes)
+{
+    void *frames[AllocationTracker::STACK_DEPTH];
+    const int depth = CaptureStack(frames);
+
+    // FNV-1a over the return addresses; 0 marks an empty slot.
+    uint64_t hash = 14695981039346656037ull;
+    for(int i = 0; i < depth; i++)
+        hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ull;
+    hash = std::max<uint64_t>(hash, 1);
+
+    const uint64_t frame = s_Frame.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+    for(int i = 0; i < AllocationTracker::MAX_CALL_SITES; i++)
+    {
+        CallSite &site = s_CallSites[(hash + i) % AllocationTracker::MAX_CALL_SITES];
+        if(site.hash == 0)
+        {
+            site.hash = hash;
+            memcpy(site.frames, frames, depth * sizeof(void *));
+            site.depth = depth;
+        }
+        else if(site.hash != hash)
+            continue;
+
+        site.allocations++;
+        site.bytes += bytes;
+        if(site.lastFrame != frame)
+        {
+            site.lastFrame = frame;
+            site.frameAllocations = 0;
+        }
+        site.frameAllocations++;
+        return;
+    }
+    s_DroppedSamples++;
+}
+
+AllocationTracker::Exemption::Exemption()
+{
+    s_Exempt++;
+}
+
+AllocationTracker::Exemption::~Exemption()
+{
+    s_Exempt--;
+}
+
+void AllocationTracker::OnAllocate(size_t bytes)
+{
+    if(s_Suspended || s_Exempt) return;
+    ThreadCounts &counts = GetThreadCounts();
+    counts.allocations.fetch_add(1, std::memory_order_relaxed);
+    counts.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    const uint32_t interval = s_SampleInterval.load(std::memory_order_relaxed);
+    bool sample = s_SampleAll.load(std::memory_order_relaxed);
+    if(!sample && interval)
+    {
+        if(s_UntilSample == 0)
+        {
+            s_UntilSample = interval;
+            sample = true;
+        }
+        s_UntilSample--;
+    }
+    if(!sample) return;
+
+    // Stack walking may allocate the first time round.
+    s_Suspended = true;
+    RecordSample(bytes);
+    s_Suspended = false;
+}
+
+void AllocationTracker::OnFree()
+{
+    if(s_Suspended || s_Exempt) return;
+    GetThreadCounts().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::SetThreadName(const char *name)
+{
+    if(!IsEnabled()) return;
+    ThreadCounts &counts = GetThreadCounts();
+    snprintf(counts.name, sizeof(counts.name), "%s", name);
+}
+
+void AllocationTracker::SetSampleInterval(uint32_t interval)
+{
+    s_SampleInterval.store(interval, std::memory_order_relaxed);
+}
+
+void AllocationTracker::SetSteadyState(bool steady)
+{
+    m_SteadyState = steady;
+    s_SampleAll.store(steady && IsEnabled(), std::memory_order_relaxed);
+}
+
+#ifdef ISKER_TRACK_ALLOCATIONS
+
+static SDL_malloc_func s_SDLMalloc;
+static SDL_calloc_func s_SDLCalloc;
+static SDL_realloc_func s_SDLRealloc;
+static SDL_free_func s_SDLFree;
+
+static void *SDLCALL TrackedMalloc(size_t size)
+{
+    AllocationTracker::OnAllocate(size);
+    return s_SDLMalloc(size);
+}
+
+static void *SDLCALL TrackedCalloc(size_t count, size_t size)
+{
+    AllocationTracker::OnAllocate(count * size);
+    return s_SDLCalloc(count, size);
+}
+
+static void *SDLCALL TrackedRealloc(void *pointer, size_t size)
+{
+    // Growing in place still goes through the heap, so every realloc counts.
+    AllocationTracker::OnAllocate(size);
+    return s_SDLRealloc(pointer, size);
+}
+
+static void SDLCALL TrackedFree(void *pointer)
+{
+    if(pointer)
+        AllocationTracker::OnFree();
+    s_SDLFree(pointer);
+}
+
+void AllocationTracker::InstallSDLHooks()
+{
+    if(s_SDLMalloc) return;
+    SDL_GetMemoryFunctions(&s_SDLMalloc, &s_SDLCalloc, &s_SDLRealloc, &s_SDLFree);
+    if(SDL_SetMemoryFunctions(TrackedMalloc, TrackedCalloc, TrackedRealloc, TrackedFree) != 0)
+        SDL_Log("Failed to hook SDL's allocator: %s\n", SDL_GetError());
+}
+
+#else
+
+void AllocationTracker::InstallSDLHooks()
+{
+}
+
+#endif
+
+void AllocationTracker::EndFrame()
+{
+    if(!IsEnabled()) return;
+
+    m_Frame = Counts();
+    const int thread_count = std::min(s_ThreadCount.load(), MAX_THREADS);
+    for(int i = 0; i < thread_count; i++)
+    {
+        Counts total;
+        total.allocations = s_Threads[i].allocations.load(std::memory_order_relaxed);
+        total.frees = s_Threads[i].frees.load(std::memory_order_relaxed);
+        total.bytes = s_Threads[i].bytes.load(std::memory_order_relaxed);
+        m_FrameCounts[i].allocations = total.allocations - m_Totals[i].allocations;
+        m_FrameCounts[i].frees = total.frees - m_Totals[i].frees;
+        m_FrameCounts[i].bytes = total.bytes - m_Totals[i].bytes;
+        m_Totals[i] = total;
+        m_Frame.allocations += m_FrameCounts[i].allocations;
+        m_Frame.frees += m_FrameCounts[i].frees;
+        m_Frame.bytes += m_FrameCounts[i].bytes;
+    }
+    const uint64_t frame = s_Frame.fetch_add(1, std::memory_order_relaxed);
+    if(!m_SteadyState || !m_Frame.allocations) return;
+
+    m_Violations++;
+    // Logging allocates, and that must not land in the next frame.
+    s_Suspended = true;
+    std::vector<CallSite> sites;
+    {
+        std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+        for(CallSite &site : s_CallSites)
+        {
+            if(site.hash == 0 || site.lastFrame != frame || site.reported) continue;
+            site.reported = true;
+            sites.push_back(site);
+        }
+    }
+
+    // Each call site is reported once; a site that allocates every frame
+    // would otherwise drown the log.
+    if(!sites.empty())
+    {
+        SDL_Log("Frame %llu allocated %llu times (%llu bytes) in steady state:\n",
+            (unsigned long long)frame, (unsigned long long)m_Frame.allocations, (unsigned long long)m_Frame.bytes);
+        for(int i = 0; i < thread_count; i++)
+            if(m_FrameCounts[i].allocations)
+                SDL_Log("  %s: %llu allocations, %llu bytes\n", s_Threads[i].name,
+                    (unsigned long long)m_FrameCounts[i].allocations, (unsigned long long)m_FrameCounts[i].bytes);
+        for(const CallSite &site : sites)
+        {
+            SDL_Log("  %llu allocations from:\n", (unsigned long long)site.frameAllocations);
+#ifdef ISKER_HAVE_BACKTRACE
+            char **symbols = backtrace_symbols(site.frames, site.depth);
+            for(int i = 0; symbols && i < site.depth; i++)
+                SDL_Log("    %s\n", symbols[i]);
+            free(symbols);
+#else
+            for(int i = 0; i < site.depth; i++)
+                SDL_Log("    %p\n", site.frames[i]);
+#endif
+        }
+    }
+    s_Suspended = false;
+    // A release assert, so --alloc-assert stops the game whatever SDL's assert level.
+    SDL_assert_release(m_ViolationMode != Violation::Assert);
+}
+
+void AllocationTracker::LogReport()
+{
+    if(!IsEnabled()) return;
+
+    s_Suspended = true;
+    SDL_Log("Allocations by thread:\n");
+    const int thread_count = std::min(s_ThreadCount.load(), MAX_THREADS);
+    for(int i = 0; i < thread_count; i++)
+        SDL_Log("  %-12s %10llu allocations %10llu frees %12llu bytes\n", s_Threads[i].name,
+            (unsigned long long)s_Threads[i].allocations.load(), (unsigned long long)s_Threads[i].frees.load(),
+            (unsigned long long)s_Threads[i].bytes.load());
+    if(m_Violations)
+        SDL_Log("%llu steady-state frames allocated.\n", (unsigned long long)m_Violations);
+
+    std::vector<CallSite> sites;
+    {
+        std::lock_guard<std::mutex> lock(s_CallSiteMutex);
+        for(const CallSite &site : s_CallSites)
+            if(site.hash != 0)
+                sites.push_back(site);
+        if(s_DroppedSamples)
+            SDL_Log("%llu samples dropped, the call site table is full.\n", (unsigned long long)s_DroppedSamples);
+    }
+    std::sort(sites.begin(), sites.end(), [](const CallSite &a, const CallSite &b) { return a.allocations > b.allocations; });
+    if(sites.size() > REPORTED_CALL_SITES)
+        sites.resize(REPORTED_CALL_SITES);
+
+    SDL_Log("Busiest sampled call sites:\n");
+    for(const CallSite &site : sites)
+    {
+        SDL_Log("  %llu samples, %llu bytes, from:\n", (unsigned long long)site.allocations, (unsigned long long)site.bytes);
+#ifdef ISKER_HAVE_BACKTRACE
+        char **symbols = backtrace_symbols(site.frames, site.depth);
+        for(int i = 0; symbols && i < site.depth; i++)
+            SDL_Log("    %s\n", symbols[i]);
+        free(symbols);
+#else
+        for(int i = 0; i < site.depth; i++)
+            SDL_Log("    %p\n", site.frames[i]);
+#endif
+    }
+    s_Suspended = false;
+}
+
+#ifdef ISKER_TRACK_ALLOCATIONS
+
+// The replaceable global allocation functions, forwarding to the C heap.
+
+static void *AlignedAllocate(size_t size, size_t alignment)
+{
+#if defined(_MSC_VER)
+    return _aligned_malloc(size ? size : 1, alignment);
+#else
+    void *pointer = nullptr;
+    if(posix_memalign(&pointer, std::max(alignment, sizeof(void *)), size ? size : 1) != 0)
+        return nullptr;
+    return pointer;
+#endif
+}
+
+static void AlignedFree(void *pointer)
+{
+#if defined(_MSC_VER)
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+void *operator new(size_t size)
+{
+    AllocationTracker::OnAllocate(size);
+    if(void *pointer = malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    AllocationTracker::OnAllocate(size);
+    return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    AllocationTracker::OnAllocate(size);
+    if(void *pointer = AlignedAllocate(size, (size_t)alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    AllocationTracker::OnAllocate(size);
+    return AlignedAllocate(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if(!pointer) return;
+    AllocationTracker::OnFree();
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept { operator delete(pointer); }
+void operator delete(void *pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { operator delete(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { operator delete(pointer); }
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    if(!pointer) return;
+    AllocationTracker::OnFree();
+    AlignedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+void operator delete(void *pointer, size_t, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+void operator delete[](void *pointer, size_t, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+void operator delete(void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept { operator delete(pointer, alignment); }
+void operator delete[](void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept { operator delete(pointer, alignment); }
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../Singleton.hpp"
+
+// Counts heap traffic through operator new and delete and SDL's allocator,
+// per thread and per main loop frame. A sample of allocations, and every
+// allocation once the game is marked steady state, records its call stack,
+// so the sites that allocate in the hot path show up by name.
+//
+// The hooks are only compiled in with ISKER_TRACK_ALLOCATIONS; without it
+// every call here does nothing and the counts stay at zero.
+class AllocationTracker
+{
+    SINGLETON(AllocationTracker);
+public:
+    // What a steady-state frame that allocates does besides counting.
+    enum class Violation { Log, Assert };
+
+    static constexpr int MAX_THREADS = 64;
+    static constexpr int STACK_DEPTH = 16;
+    static constexpr int MAX_CALL_SITES = 1024;
+    static constexpr uint32_t DEFAULT_SAMPLE_INTERVAL = 256;
+
+    struct Counts
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;
+    };
+    // While one is alive, the calling thread's heap traffic is not counted.
+    // For work that must grow storage, such as appending to a log, and that
+    // is not part of the frame's steady-state cost.
+    class Exemption
+    {
+    public:
+        Exemption();
+        ~Exemption();
+        Exemption(const Exemption&) = delete;
+    };
+private:
+    Counts m_Totals[MAX_THREADS];
+    Counts m_FrameCounts[MAX_THREADS];
+    Counts m_Frame;
+    bool m_SteadyState = false;
+    Violation m_ViolationMode = Violation::Log;
+    uint64_t m_Violations = 0;
+public:
+    static constexpr bool IsEnabled()
+    {
+#ifdef ISKER_TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Routes SDL_malloc and friends through the tracker. Call before SDL_Init.
+    void InstallSDLHooks();
+    // Names the calling thread in reports.
+    static void SetThreadName(const char *name);
+    // Every interval-th allocation on a thread records its stack; 0 turns sampling off.
+    void SetSampleInterval(uint32_t interval);
+
+    // Once set, any allocation in a frame is a violation and records its stack.
+    void SetSteadyState(bool steady);
+    bool IsSteadyState() const { return m_SteadyState; }
+    void SetViolationMode(Violation mode) { m_ViolationMode = mode; }
+
+    // Closes the main loop's frame: takes the counts of every thread since
+    // the last call and reports the frame if it broke steady state.
+    // Main thread only.
+    void EndFrame();
+    // Counts of the last ended frame, all threads together.
+    const Counts &GetFrameCounts() const { return m_Frame; }
+    // Per-thread totals and the busiest call sites.
+    void LogReport();
+
+    // Called by the allocation hooks.
+    static void OnAllocate(size_t bytes);
+    static void OnFree();
+};
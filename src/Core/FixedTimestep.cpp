@@ -0,0 +1,32 @@
+#include "FixedTimestep.hpp"
+
+FixedTimestep::FixedTimestep(float ticks_per_second, unsigned int max_ticks)
+{
+    SetRate(ticks_per_second);
+    SetMaxTicks(max_ticks);
+}
+
+void FixedTimestep::SetRate(float ticks_per_second)
+{
+    m_Step = 1.0f / (ticks_per_second > 0.0f ? ticks_per_second : 60.0f);
+    if(m_Accumulator > m_Step)
+        m_Accumulator = 0.0;
+}
+
+unsigned int FixedTimestep::Advance(float delta)
+{
+    if(delta > 0.0f)
+        m_Accumulator += delta;
+
+    unsigned int ticks = 0;
+    while(m_Accumulator >= m_Step && ticks < m_MaxTicks)
+    {
+        m_Accumulator -= m_Step;
+        ticks++;
+    }
+    // Out of ticks for this frame: let the simulation run slow rather than
+    // owing more ticks every frame.
+    if(m_Accumulator >= m_Step)
+        m_Accumulator = 0.0;
+    return ticks;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Turns variable frame times into a whole number of fixed-length simulation
+// ticks, carrying the remainder over to the next frame.
+class FixedTimestep
+{
+private:
+    float m_Step;
+    unsigned int m_MaxTicks;
+    double m_Accumulator = 0.0;
+public:
+    // max_ticks caps the ticks run for one frame. A frame that would need more
+    // drops the excess time instead of falling further behind on every frame.
+    FixedTimestep(float ticks_per_second = 60.0f, unsigned int max_ticks = 8);
+
+    void SetRate(float ticks_per_second);
+    inline void SetMaxTicks(unsigned int max_ticks) { m_MaxTicks = max_ticks ? max_ticks : 1; }
+    inline float GetStep() const { return m_Step; }
+
+    // Adds one frame's time and returns how many ticks to run now.
+    unsigned int Advance(float delta);
+    // How far the accumulated time is into the next tick, from 0 to 1. Rendering
+    // blends the previous and current simulation states by this much.
+    inline float GetAlpha() const { return (float)(m_Accumulator / m_Step); }
+};
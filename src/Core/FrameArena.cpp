@@ -0,0 +1,97 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL.h>
+#include <SDL_assert.h>
+
+// Written over freed memory in debug builds, so reads after reset stand out.
+static const uint8_t FREED_PATTERN = 0xDD;
+
+void FrameArena::Buffer::Reset()
+{
+    const size_t size = std::min(used.load(std::memory_order_relaxed), capacity);
+    if(!memory || overflowSize)
+    {
+        // Grow so the next frame like this one fits with room to spare.
+        const size_t needed = size + overflowSize;
+        capacity = std::max(INITIAL_SIZE, needed + needed / 2);
+        memory.reset(new uint8_t[capacity]);
+        overflow.clear();
+        overflowSize = 0;
+    }
+#ifndef NDEBUG
+    else
+        memset(memory.get(), FREED_PATTERN, size);
+#endif
+    used.store(0, std::memory_order_relaxed);
+}
+
+void *FrameArena::Buffer::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t offset = used.load(std::memory_order_relaxed);
+    while(true)
+    {
+        const size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if(start + bytes > capacity)
+            break;
+        if(used.compare_exchange_weak(offset, start + bytes, std::memory_order_relaxed))
+            return memory.get() + start;
+    }
+
+    // Whatever does not fit gets a block of its own until the next reset
+    // grows the buffer.
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflow.push_back(Block{ std::unique_ptr<uint8_t[]>(new uint8_t[bytes + alignment]), bytes + alignment });
+    overflowSize += bytes + alignment;
+    const uintptr_t block = (uintptr_t)overflow.back().memory.get();
+    return (void *)((block + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void FrameArena::Buffer::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+    // Nothing is freed before the reset. A pointer the buffer no longer
+    // owns comes from a container that outlived its frame.
+    SDL_assert(Owns(pointer, bytes));
+}
+
+bool FrameArena::Buffer::Owns(const void *pointer, size_t bytes)
+{
+    const uint8_t *address = (const uint8_t *)pointer;
+    if(address >= memory.get() && address + bytes <= memory.get() + std::min(used.load(), capacity))
+        return true;
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    for(const Block &block : overflow)
+        if(address >= block.memory.get() && address + bytes <= block.memory.get() + block.size)
+            return true;
+    return false;
+}
+
+std::pmr::memory_resource *FrameArena::GetResource(uint64_t frame)
+{
+    Buffer &buffer = m_Buffers[frame % BUFFER_COUNT];
+    if(!buffer.memory)
+    {
+        buffer.frame = frame;
+        buffer.Reset();
+    }
+    // Fails for a frame that has already ended, or when frames end out of order.
+    SDL_assert(buffer.frame == frame);
+    return &buffer;
+}
+
+void FrameArena::EndFrame()
+{
+    Buffer &buffer = m_Buffers[m_FramesEnded % BUFFER_COUNT];
+    if(buffer.memory)
+        buffer.Reset();
+    m_FramesEnded++;
+    buffer.frame = m_FramesEnded + BUFFER_COUNT - 1;
+}
+
+size_t FrameArena::GetUsed(uint64_t frame) const
+{
+    const Buffer &buffer = m_Buffers[frame % BUFFER_COUNT];
+    return std::min(buffer.used.load(std::memory_order_relaxed), buffer.capacity);
+}
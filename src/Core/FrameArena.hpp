@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Singleton.hpp"
+
+// Linear allocator for data that lives no longer than the frame that made
+// it. Each frame in flight bumps a pointer through a buffer of its own,
+// from any thread, and the renderer hands the buffer back whole at
+// RenderEnd. Memory is never freed piece by piece, so nothing a frame
+// allocates touches the heap once the buffers have grown to fit a frame.
+//
+// Reach the arena through FrameGraph::FrameInfo::memory, which is the
+// resource of that frame, and use ArenaVector or ArenaString rather than
+// the std containers. Containers must be destroyed before the frame's
+// RenderEnd. Debug builds check for use after reset, and overwrite freed
+// memory so stale reads show up as garbage.
+class FrameArena
+{
+    SINGLETON(FrameArena);
+public:
+    static constexpr unsigned int BUFFER_COUNT = 2;
+    static constexpr size_t INITIAL_SIZE = 256 * 1024;
+private:
+    class Buffer : public std::pmr::memory_resource
+    {
+    public:
+        std::unique_ptr<uint8_t[]> memory;
+        size_t capacity = 0;
+        std::atomic<size_t> used{ 0 };
+        // Allocations that did not fit, freed and folded into the next
+        // buffer size at reset.
+        struct Block
+        {
+            std::unique_ptr<uint8_t[]> memory;
+            size_t size;
+        };
+        std::vector<Block> overflow;
+        size_t overflowSize = 0;
+        std::mutex overflowMutex;
+        // The frame allowed to allocate from this buffer.
+        uint64_t frame = 0;
+
+        void Reset();
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    private:
+        bool Owns(const void *pointer, size_t bytes);
+    };
+    Buffer m_Buffers[BUFFER_COUNT];
+    uint64_t m_FramesEnded = 0;
+public:
+    // The resource of a frame in flight.
+    std::pmr::memory_resource *GetResource(uint64_t frame);
+    // Frees everything the oldest frame allocated. Called by Renderer::RenderEnd.
+    void EndFrame();
+    // Bytes a frame in flight has allocated so far, for profiling.
+    size_t GetUsed(uint64_t frame) const;
+};
+
+template<typename T>
+using ArenaVector = std::pmr::vector<T>;
+using ArenaString = std::pmr::string;
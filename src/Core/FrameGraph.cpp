@@ -0,0 +1,301 @@
+#include "FrameGraph.hpp"
+
+#include <algorithm>
+
+#include "FrameArena.hpp"
+
+static bool Contains(const std::vector<std::string> &names, const std::string &name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+void FrameGraph::AddResource(const std::string &name, unsigned int copies)
+{
+    copies = std::max(1u, std::min(copies, MAX_FRAMES_IN_FLIGHT));
+    for(auto &resource : m_Resources)
+    {
+        if(resource.first == name)
+        {
+            resource.second = copies;
+            m_Compiled = false;
+            return;
+        }
+    }
+    m_Resources.emplace_back(name, copies);
+    m_Compiled = false;
+}
+
+void FrameGraph::AddStage(const std::string &name, const std::vector<std::string> &reads, const std::vector<std::string> &writes, StageFunction function, Affinity affinity)
+{
+    Stage stage;
+    stage.name = name;
+    stage.writes = writes;
+    // A stage that writes a resource may read it too; only the write matters for ordering.
+    for(const std::string &read : reads)
+        if(!Contains(writes, read))
+            stage.reads.push_back(read);
+    stage.function = std::move(function);
+    stage.affinity = affinity;
+    m_Stages.push_back(std::move(stage));
+    m_Compiled = false;
+}
+
+void FrameGraph::SetFramesInFlight(unsigned int frames)
+{
+    Flush();
+    m_FramesInFlight = std::max(1u, std::min(frames, MAX_FRAMES_IN_FLIGHT));
+}
+
+unsigned int FrameGraph::GetCopies(const std::string &resource) const
+{
+    for(const auto &declared : m_Resources)
+        if(declared.first == resource)
+            return declared.second;
+    return 1;
+}
+
+void FrameGraph::Compile()
+{
+    Flush();
+
+    // Within a frame a stage follows the last earlier writer of everything it
+    // touches, and a writer also follows the readers since that write.
+    struct Access
+    {
+        int writer = -1;
+        std::vector<uint32_t> readers;
+    };
+    std::vector<std::pair<std::string, Access>> accesses;
+    auto access_of = [&accesses](const std::string &resource) -> Access & {
+        for(auto &access : accesses)
+            if(access.first == resource)
+                return access.second;
+        accesses.emplace_back(resource, Access());
+        return accesses.back().second;
+    };
+
+    for(uint32_t i = 0; i < m_Stages.size(); i++)
+    {
+        Stage &stage = m_Stages[i];
+        stage.dependencyCount = 0;
+        stage.dependents.clear();
+        stage.previousFrameDependencies.clear();
+        stage.edges.clear();
+
+        auto depend_on = [&](uint32_t from, const std::string &resource, bool previous_frame) {
+            for(Edge &edge : stage.edges)
+            {
+                if(edge.from == from && edge.previousFrame == previous_frame)
+                {
+                    if(edge.resources.find(resource) == std::string::npos)
+                        edge.resources += ", " + resource;
+                    return;
+                }
+            }
+            stage.edges.push_back(Edge{ from, resource, previous_frame });
+            if(previous_frame)
+            {
+                stage.previousFrameDependencies.push_back(from);
+            }
+            else
+            {
+                m_Stages[from].dependents.push_back(i);
+                stage.dependencyCount++;
+            }
+        };
+
+        for(const std::string &resource : stage.reads)
+        {
+            const Access &access = access_of(resource);
+            if(access.writer >= 0)
+                depend_on((uint32_t)access.writer, resource, false);
+        }
+        for(const std::string &resource : stage.writes)
+        {
+            const Access &access = access_of(resource);
+            if(access.writer >= 0)
+                depend_on((uint32_t)access.writer, resource, false);
+            for(uint32_t reader : access.readers)
+                depend_on(reader, resource, false);
+        }
+        for(const std::string &resource : stage.reads)
+            access_of(resource).readers.push_back(i);
+        for(const std::string &resource : stage.writes)
+        {
+            Access &access = access_of(resource);
+            access.writer = (int)i;
+            access.readers.clear();
+        }
+    }
+
+    // Across frames a stage waits for its own previous run, and for every
+    // stage of the previous frame that shares a single-copy resource with it
+    // where either side writes.
+    for(uint32_t i = 0; i < m_Stages.size(); i++)
+    {
+        Stage &stage = m_Stages[i];
+        for(uint32_t j = 0; j < m_Stages.size(); j++)
+        {
+            const Stage &other = m_Stages[j];
+            std::string shared;
+            auto conflict = [&](const std::string &resource) {
+                if(GetCopies(resource) > 1 || shared.find(resource) != std::string::npos) return;
+                shared += (shared.empty() ? "" : ", ") + resource;
+            };
+            for(const std::string &resource : stage.writes)
+                if(Contains(other.writes, resource) || Contains(other.reads, resource))
+                    conflict(resource);
+            for(const std::string &resource : stage.reads)
+                if(Contains(other.writes, resource))
+                    conflict(resource);
+
+            if(!shared.empty())
+            {
+                stage.edges.push_back(Edge{ j, shared, true });
+                stage.previousFrameDependencies.push_back(j);
+            }
+            else if(i == j)
+            {
+                stage.edges.push_back(Edge{ j, "", true });
+                stage.previousFrameDependencies.push_back(j);
+            }
+        }
+    }
+
+    for(FrameState &frame : m_Frames)
+    {
+        frame.stages.reset(new StageState[m_Stages.size()]);
+        for(uint32_t i = 0; i < m_Stages.size(); i++)
+        {
+            frame.stages[i].done = true;
+            frame.stages[i].frame = &frame;
+            frame.stages[i].stage = i;
+        }
+    }
+    m_Compiled = true;
+}
+
+void FrameGraph::Execute(float delta)
+{
+    if(!m_Compiled)
+        Compile();
+
+    JobSystem &jobs = JobSystem::Get();
+    const uint64_t index = m_FrameCount++;
+    FrameState &frame = m_Frames[index % m_FramesInFlight];
+    // The frame that used this slot last has to be done with it.
+    if(frame.started)
+        jobs.Wait(frame.done, false);
+    frame.info = FrameInfo{ index, delta, FrameArena::Get().GetResource(index) };
+    frame.started = true;
+
+    // Every stage starts one above its real dependency count, so none can
+    // launch before all of them are wired up.
+    for(size_t i = 0; i < m_Stages.size(); i++)
+    {
+        StageState &state = frame.stages[i];
+        state.pending = (int)m_Stages[i].dependencyCount + 1;
+        state.done = false;
+        state.nextFrameDependents.clear();
+        jobs.Retain(frame.done);
+    }
+
+    FrameState &previous = m_Frames[(index + m_FramesInFlight - 1) % m_FramesInFlight];
+    if(m_FramesInFlight > 1 && previous.started && previous.info.index + 1 == index)
+    {
+        for(uint32_t i = 0; i < m_Stages.size(); i++)
+        {
+            for(uint32_t dependency : m_Stages[i].previousFrameDependencies)
+            {
+                StageState &other = previous.stages[dependency];
+                std::lock_guard<std::mutex> lock(other.mutex);
+                if(other.done) continue;
+                other.nextFrameDependents.push_back(i);
+                frame.stages[i].pending++;
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < m_Stages.size(); i++)
+        if(frame.stages[i].pending.fetch_sub(1) == 1)
+            Launch(frame, i);
+
+    // With one frame in flight this is the frame just started.
+    FrameState &oldest = m_Frames[(index + 1) % m_FramesInFlight];
+    jobs.Wait(oldest.done, false);
+}
+
+void FrameGraph::Flush()
+{
+    for(unsigned int i = 0; i < m_FramesInFlight; i++)
+        if(m_Frames[i].started)
+            JobSystem::Get().Wait(m_Frames[i].done, false);
+}
+
+void FrameGraph::Launch(FrameState &frame, uint32_t stage)
+{
+    // Small enough for std::function to store without allocating.
+    StageState *state = &frame.stages[stage];
+    auto run = [this, state]() {
+        m_Stages[state->stage].function(state->frame->info);
+        Finish(*state->frame, state->stage);
+    };
+    if(m_Stages[stage].affinity == Affinity::MainThread)
+        JobSystem::Get().SubmitMainThread(std::move(run), nullptr, m_Stages[stage].name.c_str());
+    else
+        JobSystem::Get().Submit(std::move(run), nullptr, m_Stages[stage].name.c_str());
+}
+
+void FrameGraph::Finish(FrameState &frame, uint32_t stage)
+{
+    for(uint32_t dependent : m_Stages[stage].dependents)
+        if(frame.stages[dependent].pending.fetch_sub(1) == 1)
+            Launch(frame, dependent);
+
+    // Once done is set nothing is added to the list, and it is only cleared
+    // when this frame's slot is reused, so it can be read without the lock.
+    StageState &state = frame.stages[stage];
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.done = true;
+    }
+    if(!state.nextFrameDependents.empty())
+    {
+        FrameState &next = m_Frames[(frame.info.index + 1) % m_FramesInFlight];
+        for(uint32_t dependent : state.nextFrameDependents)
+            if(next.stages[dependent].pending.fetch_sub(1) == 1)
+                Launch(next, dependent);
+    }
+
+    // Last: once the counter reaches zero the slot may be reused.
+    JobSystem::Get().Release(frame.done);
+}
+
+std::string FrameGraph::Dump()
+{
+    if(!m_Compiled)
+        Compile();
+
+    std::string dot = "digraph FrameGraph {\n";
+    for(const Stage &stage : m_Stages)
+    {
+        dot += "    \"" + stage.name + "\"";
+        if(stage.affinity == Affinity::MainThread)
+            dot += " [style=bold, label=\"" + stage.name + "\\n(main thread)\"]";
+        dot += ";\n";
+    }
+    for(const Stage &stage : m_Stages)
+    {
+        for(const Edge &edge : stage.edges)
+        {
+            // Waiting for the previous frame is only meaningful with more than one in flight.
+            if(edge.previousFrame && m_FramesInFlight < 2) continue;
+            dot += "    \"" + m_Stages[edge.from].name + "\" -> \"" + stage.name + "\" [label=\"" + edge.resources + "\"";
+            if(edge.previousFrame)
+                dot += ", style=dashed";
+            dot += "];\n";
+        }
+    }
+    dot += "}\n";
+    return dot;
+}
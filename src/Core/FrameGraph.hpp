@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "JobSystem.hpp"
+
+// The work of one frame as a graph of stages. Each stage names the resources
+// it reads and writes, and the graph orders stages by those accesses alone:
+// stages that do not conflict run at the same time on the job system.
+//
+// With two frames in flight, a frame starts before the previous one has
+// finished, so the late stages of one frame overlap the early stages of the
+// next. A stage then also waits for the previous frame's stages that touch
+// the same single-copy resources, and for its own previous run. Resources
+// declared with two copies are double buffered: each frame uses the copy
+// FrameInfo::Copy picks, so frames in flight never share one.
+class FrameGraph
+{
+public:
+    static constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 2;
+    struct FrameInfo
+    {
+        uint64_t index;
+        float delta;
+        // The frame's FrameArena, for anything that can be dropped at RenderEnd.
+        std::pmr::memory_resource *memory;
+        // Which copy of a resource with this many copies the frame uses.
+        inline unsigned int Copy(unsigned int copies) const { return (unsigned int)(index % copies); }
+    };
+    typedef std::function<void(const FrameInfo &)> StageFunction;
+    enum class Affinity { Any, MainThread };
+private:
+    struct Edge
+    {
+        uint32_t from;
+        std::string resources;
+        bool previousFrame;
+    };
+    struct Stage
+    {
+        std::string name;
+        std::vector<std::string> reads, writes;
+        StageFunction function;
+        Affinity affinity;
+        // Set by Compile.
+        unsigned int dependencyCount;
+        std::vector<uint32_t> dependents;
+        std::vector<uint32_t> previousFrameDependencies;
+        std::vector<Edge> edges;
+    };
+    struct FrameState;
+    struct StageState
+    {
+        std::atomic<int> pending;
+        std::mutex mutex;
+        bool done;
+        // Stages of the next frame waiting for this one.
+        std::vector<uint32_t> nextFrameDependents;
+        // Where the state belongs, so a job needs only a pointer to it.
+        FrameState *frame;
+        uint32_t stage;
+    };
+    struct FrameState
+    {
+        FrameInfo info;
+        std::unique_ptr<StageState[]> stages;
+        JobCounter done;
+        bool started = false;
+    };
+    std::vector<std::pair<std::string, unsigned int>> m_Resources;
+    std::vector<Stage> m_Stages;
+    std::array<FrameState, MAX_FRAMES_IN_FLIGHT> m_Frames;
+    unsigned int m_FramesInFlight = 1;
+    bool m_Compiled = false;
+    uint64_t m_FrameCount = 0;
+public:
+    // copies is 1 or 2. Resources a stage names without declaring have one copy.
+    void AddResource(const std::string &name, unsigned int copies);
+    // Stages are ordered as added wherever their accesses conflict.
+    void AddStage(const std::string &name, const std::vector<std::string> &reads, const std::vector<std::string> &writes, StageFunction function, Affinity affinity = Affinity::Any);
+    // 1 runs each frame to completion; 2 lets the next frame start early.
+    void SetFramesInFlight(unsigned int frames);
+    inline unsigned int GetFramesInFlight() const { return m_FramesInFlight; }
+    inline uint64_t GetFrameCount() const { return m_FrameCount; }
+
+    // Starts a frame, then waits until at most GetFramesInFlight() - 1
+    // frames are unfinished. Call on the main thread; it runs the
+    // main-thread stages while it waits.
+    void Execute(float delta);
+    // Waits for every frame in flight to finish.
+    void Flush();
+    // The graph in Graphviz dot format. Dashed edges come from the previous frame.
+    std::string Dump();
+private:
+    void Compile();
+    unsigned int GetCopies(const std::string &resource) const;
+    void Launch(FrameState &frame, uint32_t stage);
+    void Finish(FrameState &frame, uint32_t stage);
+};
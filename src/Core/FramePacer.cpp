@@ -0,0 +1,187 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+
+// With less time than this left, SDL_Delay is too coarse and the rest is spun.
+static constexpr double SPIN_THRESHOLD = 0.002;
+// Kept between the predicted end of a low-latency frame and its deadline.
+static constexpr double LATENCY_MARGIN = 0.001;
+static constexpr double REPORT_INTERVAL = 5.0;
+
+void FramePacer::Init(SDL_Window *pWindow)
+{
+    m_Frequency = SDL_GetPerformanceFrequency();
+
+    SDL_DisplayMode mode;
+    const int display = SDL_GetWindowDisplayIndex(pWindow);
+    if(display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0 && mode.refresh_rate > 0)
+        m_RefreshRate = (float)mode.refresh_rate;
+
+    m_LastSwap = m_ReportStart = SDL_GetPerformanceCounter();
+    SetVSync(VSync::Adaptive);
+}
+
+FramePacer::VSync FramePacer::SetVSync(VSync vsync)
+{
+    m_Deadline = 0;
+#ifdef __EMSCRIPTEN__
+    // The browser always waits for the display, and the swap interval would
+    // change the timing of the main loop instead.
+    (void)vsync;
+    return m_VSync = VSync::On;
+#else
+    if(vsync == VSync::Adaptive)
+    {
+        // Late frames are shown straight away instead of waiting a whole refresh.
+        if(SDL_GL_SetSwapInterval(-1) == 0)
+            return m_VSync = VSync::Adaptive;
+        SDL_Log("Adaptive vsync unsupported, using vsync: %s\n", SDL_GetError());
+        vsync = VSync::On;
+    }
+    if(vsync == VSync::On)
+    {
+        if(SDL_GL_SetSwapInterval(1) == 0)
+            return m_VSync = VSync::On;
+        SDL_Log("Vsync unsupported, pacing frames with a timer: %s\n", SDL_GetError());
+    }
+    SDL_GL_SetSwapInterval(0);
+    return m_VSync = VSync::Off;
+#endif
+}
+
+void FramePacer::SetFrameCap(float frames_per_second)
+{
+    m_FrameCap = std::max(0.0f, frames_per_second);
+    m_Deadline = 0;
+}
+
+void FramePacer::SetLowLatency(bool low_latency)
+{
+    m_LowLatency = low_latency;
+}
+
+void FramePacer::SetUnpaced(bool unpaced)
+{
+    m_Unpaced = unpaced;
+    if(unpaced)
+        SetVSync(VSync::Off);
+    m_Deadline = 0;
+}
+
+void FramePacer::RequestRedrawIn(float seconds)
+{
+    const Uint64 time = SDL_GetPerformanceCounter() + (Uint64)(std::max(0.0f, seconds) * m_Frequency);
+    if(!m_RedrawTime || time < m_RedrawTime)
+        m_RedrawTime = time;
+}
+
+int FramePacer::GetIdleTimeout() const
+{
+    if(!m_OnDemand || m_RedrawRequested) return 0;
+    if(!m_RedrawTime) return -1;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    if(now >= m_RedrawTime) return 0;
+    // Round up so the wait does not end just short of the deadline and spin.
+    return (int)(((m_RedrawTime - now) * 1000 + m_Frequency - 1) / m_Frequency);
+}
+
+double FramePacer::GetFramePeriod() const
+{
+    const double refresh = 1.0 / m_RefreshRate;
+    if(m_Unpaced) return 0.0;
+    if(m_FrameCap <= 0.0f) return refresh;
+    // Without vsync a cap above the refresh rate trades tearing for latency.
+    return m_VSync == VSync::Off ? 1.0 / m_FrameCap : std::max(refresh, 1.0 / m_FrameCap);
+}
+
+void FramePacer::BeginFrame()
+{
+    const double period = GetFramePeriod();
+    const Uint64 period_ticks = (Uint64)(period * m_Frequency);
+    const Uint64 now = SDL_GetPerformanceCounter();
+
+#ifdef __EMSCRIPTEN__
+    m_TimerPaced = false;
+#else
+    // Vsync alone holds the loop to the refresh rate; anything slower needs the timer.
+    m_TimerPaced = m_VSync == VSync::Off || period > 1.0 / m_RefreshRate * 1.01;
+#endif
+    // Deadlines advance by whole periods so the rate does not drift. With
+    // vsync the blocking swap returns at a vblank, so the next one is a
+    // refresh after it.
+    m_Deadline = (m_TimerPaced ? m_Deadline : m_LastSwap) + period_ticks;
+    // After an overrun or an idle wait the schedule restarts from now rather
+    // than rushing to catch up.
+    if(m_Deadline < now)
+        m_Deadline = now + period_ticks;
+
+#ifndef __EMSCRIPTEN__
+    Uint64 wake = m_TimerPaced ? m_Deadline - period_ticks : now;
+    if(m_LowLatency)
+    {
+        // Start only as early as the frame is expected to need, so input is
+        // sampled as late as possible.
+        const double lead = m_WorkTime + std::max(LATENCY_MARGIN, m_WorkTime * 0.25);
+        const Uint64 lead_ticks = (Uint64)(lead * m_Frequency);
+        if(lead_ticks < period_ticks)
+            wake = std::max(wake, m_Deadline - lead_ticks);
+    }
+    WaitUntil(wake);
+#endif
+    m_FrameStart = SDL_GetPerformanceCounter();
+
+    // Requests made from here on are for the next frame.
+    m_RedrawRequested = false;
+    if(m_RedrawTime && m_RedrawTime <= m_FrameStart)
+        m_RedrawTime = 0;
+}
+
+void FramePacer::BeforeSwap()
+{
+    const double work = (double)(SDL_GetPerformanceCounter() - m_FrameStart) / m_Frequency;
+    // Follow a slower frame quickly and a faster one slowly, so one cheap
+    // frame does not push the next start too late.
+    if(m_WorkTime <= 0.0)
+        m_WorkTime = work;
+    else
+        m_WorkTime += (work - m_WorkTime) * (work > m_WorkTime ? 0.5 : 0.05);
+}
+
+void FramePacer::AfterSwap()
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    m_LastSwap = now;
+    if(!m_Deadline || m_Unpaced) return;
+
+    // A blocking swap returns near a vblank, which may fall up to a refresh
+    // after a limiter deadline, so allow for that much jitter.
+    double tolerance = 0.0;
+    if(m_VSync != VSync::Off)
+        tolerance = (m_TimerPaced ? 1.0 : 0.5) / m_RefreshRate;
+    m_ReportFrames++;
+    if(now > m_Deadline + (Uint64)(tolerance * m_Frequency))
+    {
+        m_MissedDeadlines++;
+        m_ReportMissed++;
+    }
+
+    if(now - m_ReportStart >= (Uint64)(REPORT_INTERVAL * m_Frequency))
+    {
+        if(m_ReportMissed)
+            SDL_Log("Missed %u of %u frame deadlines in the last %.0f s\n", m_ReportMissed, m_ReportFrames, REPORT_INTERVAL);
+        m_ReportFrames = m_ReportMissed = 0;
+        m_ReportStart = now;
+    }
+}
+
+void FramePacer::WaitUntil(Uint64 time) const
+{
+    const Uint64 spin = (Uint64)(SPIN_THRESHOLD * m_Frequency);
+    for(Uint64 now = SDL_GetPerformanceCounter(); now < time; now = SDL_GetPerformanceCounter())
+    {
+        // SDL_Delay can oversleep by a millisecond or more, so it stops short
+        // of the target and the remainder is spun.
+        if(time - now > spin)
+            SDL_Delay((Uint32)((time - now - spin) * 1000 / m_Frequency));
+    }
+}
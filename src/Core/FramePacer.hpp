@@ -0,0 +1,83 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "../Singleton.hpp"
+
+// Decides when each frame starts. It sets the swap interval, limits the frame
+// rate with a sleep followed by a short spin, and in low-latency mode holds
+// the start of the frame back so input is sampled as close to the swap as
+// the measured frame cost allows. Late frames are counted and logged.
+// On the web requestAnimationFrame paces frames, so nothing waits there and
+// only the missed deadlines are tracked.
+class FramePacer
+{
+    SINGLETON(FramePacer);
+public:
+    enum class VSync { Off, On, Adaptive };
+private:
+    VSync m_VSync = VSync::Off;
+    float m_FrameCap = 0.0f;
+    bool m_LowLatency = false;
+    bool m_Unpaced = false;
+    float m_RefreshRate = 60.0f;
+
+    Uint64 m_Frequency = 1;
+    // When the frame being built should reach the screen, or 0 before the first frame.
+    Uint64 m_Deadline = 0;
+    // Whether the deadline comes from the limiter rather than from vsync.
+    bool m_TimerPaced = false;
+    Uint64 m_FrameStart = 0;
+    Uint64 m_LastSwap = 0;
+    // Smoothed cost of a frame from its start to the swap call.
+    double m_WorkTime = 0.0;
+
+    bool m_OnDemand = false;
+    bool m_RedrawRequested = true;
+    // When a timed redraw is due, or 0 if none is scheduled.
+    Uint64 m_RedrawTime = 0;
+
+    unsigned int m_MissedDeadlines = 0;
+    unsigned int m_ReportFrames = 0;
+    unsigned int m_ReportMissed = 0;
+    Uint64 m_ReportStart = 0;
+public:
+    // Reads the display refresh rate and turns on adaptive vsync.
+    void Init(SDL_Window *pWindow);
+    // Falls back from adaptive to regular vsync, and from that to off, when
+    // the driver refuses. Returns the mode in effect.
+    VSync SetVSync(VSync vsync);
+    // Frames per second; 0 removes the cap. Without vsync an uncapped loop is
+    // still held to the display refresh rate rather than spinning.
+    void SetFrameCap(float frames_per_second);
+    void SetLowLatency(bool low_latency);
+    // Runs frames back to back with vsync off and no deadlines to miss, for benchmark playback.
+    void SetUnpaced(bool unpaced);
+
+    // In on-demand mode the loop sleeps in SDL_WaitEventTimeout and only draws
+    // when input arrives or a redraw is requested, for menus and tools.
+    inline void SetOnDemand(bool on_demand) { m_OnDemand = on_demand; m_RedrawRequested = true; }
+    inline bool IsOnDemand() const { return m_OnDemand; }
+    // Draws another frame as soon as possible. Anything animating calls this every frame.
+    inline void RequestRedraw() { m_RedrawRequested = true; }
+    // Draws a frame within this many seconds, for timers and blinking cursors.
+    void RequestRedrawIn(float seconds);
+    // Milliseconds until a frame is due: 0 if one is due now, -1 if none is scheduled.
+    int GetIdleTimeout() const;
+
+    inline VSync GetVSync() const { return m_VSync; }
+    inline float GetRefreshRate() const { return m_RefreshRate; }
+    inline bool IsLowLatency() const { return m_LowLatency; }
+    // Frames that reached the screen later than their deadline since Init.
+    inline unsigned int GetMissedDeadlines() const { return m_MissedDeadlines; }
+
+    // Call at the top of the loop, before polling input. Waits until the frame should start.
+    void BeginFrame();
+    // The renderer calls these around SDL_GL_SwapWindow.
+    void BeforeSwap();
+    void AfterSwap();
+private:
+    // Seconds between frames: the cap, but with vsync never shorter than a refresh.
+    double GetFramePeriod() const;
+    void WaitUntil(Uint64 time) const;
+};
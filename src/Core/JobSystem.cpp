@@ -0,0 +1,313 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "AllocationTracker.hpp"
+
+// Jobs a single deque holds before the rest spill into the shared queue.
+static constexpr int64_t DEQUE_CAPACITY = 4096;
+
+struct Job
+{
+    std::function<void()> function;
+    JobCounter *counter;
+    const char *name;
+    bool mainThread;
+    // The next job held back by the same dependency.
+    Job *next;
+};
+
+// Index of this thread's deque, or -1 on threads outside the system.
+static thread_local int s_Worker = -1;
+
+void JobSystem::Init(unsigned int thread_count)
+{
+#ifdef __EMSCRIPTEN__
+    // The web build is single threaded; the main thread runs every job while it waits.
+    thread_count = 0;
+#else
+    if(!thread_count)
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+#endif
+
+    s_Worker = 0;
+    m_Stopping = false;
+    m_Deques.clear();
+    for(unsigned int i = 0; i <= thread_count; i++)
+        m_Deques.push_back(std::make_unique<WorkStealingDeque<Job *>>(DEQUE_CAPACITY));
+    for(unsigned int i = 1; i <= thread_count; i++)
+        m_Threads.emplace_back(&JobSystem::WorkerLoop, this, (int)i);
+}
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Stopping = true;
+    }
+    m_SleepCondition.notify_all();
+    for(std::thread &thread : m_Threads)
+        thread.join();
+    m_Threads.clear();
+
+    // Workers drain the shared queues before they stop; only main-thread jobs can be left.
+    RunMainThreadJobs();
+    while(Job *job = FindJob(s_Worker))
+        Execute(job, s_Worker);
+
+    for(Job *job : m_FreeJobs)
+        delete job;
+    m_FreeJobs.clear();
+}
+
+void JobSystem::Submit(std::function<void()> function, JobCounter *counter, const char *name)
+{
+    Schedule(NewJob(std::move(function), counter, name, false));
+}
+
+void JobSystem::SubmitAfter(JobCounter &dependency, std::function<void()> function, JobCounter *counter, const char *name)
+{
+    Job *job = NewJob(std::move(function), counter, name, false);
+    if(counter)
+        Retain(*counter);
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+        if(dependency.m_Count.load(std::memory_order_acquire) != 0)
+        {
+            job->next = dependency.m_Continuations;
+            dependency.m_Continuations = job;
+            return;
+        }
+    }
+    Enqueue(job);
+}
+
+void JobSystem::SubmitMainThread(std::function<void()> function, JobCounter *counter, const char *name)
+{
+    Schedule(NewJob(std::move(function), counter, name, true));
+}
+
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body, const char *name)
+{
+    if(begin >= end) return;
+
+    // A few ranges per thread leaves room to even out uneven work by stealing.
+    const size_t ranges = (size_t)(GetThreadCount() + 1) * 4;
+    const size_t size = std::max(std::max<size_t>(grain, 1), (end - begin + ranges - 1) / ranges);
+
+    JobCounter counter;
+    for(size_t first = begin + size; first < end; first += size)
+    {
+        const size_t last = std::min(end, first + size);
+        Submit([&body, first, last]() { body(first, last); }, &counter, name);
+    }
+    // The calling thread takes the first range itself.
+    body(begin, std::min(end, begin + size));
+    Wait(counter);
+}
+
+void JobSystem::Retain(JobCounter &counter)
+{
+    counter.m_Count.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::Release(JobCounter &counter)
+{
+    // Decremented under the lock so a waiter that sees zero and then takes
+    // the lock knows this thread is done with the counter.
+    Job *released = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_Mutex);
+        if(counter.m_Count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            released = counter.m_Continuations;
+            counter.m_Continuations = nullptr;
+        }
+    }
+    while(released)
+    {
+        Job *next = released->next;
+        Enqueue(released);
+        released = next;
+    }
+}
+
+void JobSystem::Wait(JobCounter &counter, bool help)
+{
+    const int worker = s_Worker;
+    // With no workers the main thread is the only one that can run anything.
+    help = help || worker != 0 || m_Threads.empty();
+    while(!counter.IsDone())
+    {
+        Job *job = worker == 0 ? TakeMainThreadJob() : nullptr;
+        if(!job && help)
+            job = FindJob(worker);
+        if(job) Execute(job, worker);
+        else std::this_thread::yield();
+    }
+    // The job that finished last may still be holding the counter's lock.
+    std::lock_guard<std::mutex> lock(counter.m_Mutex);
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    // Only what is queued now, so a job that queues another cannot keep the frame here.
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+        count = m_MainThreadJobs.size() - m_MainThreadHead;
+    }
+    for(; count; count--)
+    {
+        Job *job = TakeMainThreadJob();
+        if(!job) break;
+        Execute(job, 0);
+    }
+}
+
+Job *JobSystem::NewJob(std::function<void()> &&function, JobCounter *counter, const char *name, bool main_thread)
+{
+    Job *job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_FreeJobsMutex);
+        if(!m_FreeJobs.empty())
+        {
+            job = m_FreeJobs.back();
+            m_FreeJobs.pop_back();
+        }
+    }
+    if(!job)
+        return new Job{ std::move(function), counter, name, main_thread, nullptr };
+    *job = Job{ std::move(function), counter, name, main_thread, nullptr };
+    return job;
+}
+
+void JobSystem::Schedule(Job *job)
+{
+    if(job->counter)
+        Retain(*job->counter);
+    Enqueue(job);
+}
+
+void JobSystem::Enqueue(Job *job)
+{
+    if(job->mainThread)
+    {
+        std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+        m_MainThreadJobs.push_back(job);
+        return;
+    }
+
+    // Counted before it is visible, so a thread that takes it never sees the count below zero.
+    m_Queued.fetch_add(1);
+    const int worker = s_Worker;
+    if(worker < 0 || worker >= (int)m_Deques.size() || !m_Deques[worker]->Push(job))
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedMutex);
+        m_Injected.push_back(job);
+    }
+
+    // A worker checks m_Queued under this lock before it sleeps, so the wake-up cannot be lost.
+    if(m_Sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_SleepCondition.notify_one();
+    }
+}
+
+Job *JobSystem::FindJob(int worker)
+{
+    const int deque_count = (int)m_Deques.size();
+    Job *job = nullptr;
+    if(worker >= 0 && worker < deque_count)
+        job = m_Deques[worker]->Pop();
+
+    if(!job && m_Queued.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_InjectedMutex);
+            if(m_InjectedHead < m_Injected.size())
+            {
+                job = m_Injected[m_InjectedHead++];
+                if(m_InjectedHead == m_Injected.size())
+                {
+                    m_Injected.clear();
+                    m_InjectedHead = 0;
+                }
+            }
+        }
+        // Start with the next deque along so thieves spread out over the victims.
+        for(int i = 1; !job && i <= deque_count; i++)
+        {
+            const int victim = (worker + i + deque_count) % deque_count;
+            if(victim != worker)
+                job = m_Deques[victim]->Steal();
+        }
+    }
+
+    if(job)
+        m_Queued.fetch_sub(1);
+    return job;
+}
+
+Job *JobSystem::TakeMainThreadJob()
+{
+    std::lock_guard<std::mutex> lock(m_MainThreadMutex);
+    if(m_MainThreadHead == m_MainThreadJobs.size()) return nullptr;
+    Job *job = m_MainThreadJobs[m_MainThreadHead++];
+    if(m_MainThreadHead == m_MainThreadJobs.size())
+    {
+        m_MainThreadJobs.clear();
+        m_MainThreadHead = 0;
+    }
+    return job;
+}
+
+void JobSystem::Execute(Job *job, int worker)
+{
+    if(m_ProfileHook)
+    {
+        JobProfile profile;
+        profile.name = job->name;
+        profile.worker = worker;
+        profile.start = std::chrono::steady_clock::now();
+        job->function();
+        profile.end = std::chrono::steady_clock::now();
+        m_ProfileHook(profile);
+    }
+    else
+    {
+        job->function();
+    }
+
+    if(job->counter)
+        Release(*job->counter);
+    // Captures are released now rather than when the job is next reused.
+    job->function = nullptr;
+    std::lock_guard<std::mutex> lock(m_FreeJobsMutex);
+    m_FreeJobs.push_back(job);
+}
+
+void JobSystem::WorkerLoop(int worker)
+{
+    s_Worker = worker;
+    char name[16];
+    snprintf(name, sizeof(name), "Worker %d", worker);
+    AllocationTracker::SetThreadName(name);
+    while(true)
+    {
+        if(Job *job = FindJob(worker))
+        {
+            Execute(job, worker);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        if(m_Stopping && m_Queued.load() <= 0)
+            return;
+        m_Sleeping++;
+        m_SleepCondition.wait(lock, [this] { return m_Stopping || m_Queued.load() > 0; });
+        m_Sleeping--;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingDeque.hpp"
+#include "../Singleton.hpp"
+
+// Defined in JobSystem.cpp.
+struct Job;
+
+// Counts unfinished jobs. Jobs submitted with a counter add to it and take
+// away from it when done, and jobs can be held back until a counter reaches
+// zero. Destroy a counter only after JobSystem::Wait has returned for it.
+class JobCounter
+{
+    friend class JobSystem;
+private:
+    Job *m_Continuations = nullptr;
+    std::atomic<int> m_Count{ 0 };
+    std::mutex m_Mutex;
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    void operator=(const JobCounter&) = delete;
+    inline bool IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+};
+
+// The engine's task scheduler. Every core but the main thread's runs a
+// worker with its own work-stealing deque; the main thread has one too and
+// helps while it waits. Jobs must not touch OpenGL unless they are submitted
+// with SubmitMainThread.
+class JobSystem
+{
+    SINGLETON(JobSystem);
+public:
+    // Passed to the profile hook after each job, on the thread that ran it.
+    struct JobProfile
+    {
+        const char *name;
+        // 0 is the main thread, -1 a thread outside the system that helped while waiting.
+        int worker;
+        std::chrono::steady_clock::time_point start, end;
+    };
+    typedef std::function<void(const JobProfile &)> ProfileHook;
+private:
+    std::vector<std::thread> m_Threads;
+    // One per worker, with the main thread's first.
+    std::vector<std::unique_ptr<WorkStealingDeque<Job *>>> m_Deques;
+    // Jobs from threads without a deque, and overflow from full deques.
+    // These queues are vectors read from a head index and emptied whole, so
+    // once they have grown queuing never allocates.
+    std::vector<Job *> m_Injected;
+    size_t m_InjectedHead = 0;
+    std::mutex m_InjectedMutex;
+    std::vector<Job *> m_MainThreadJobs;
+    size_t m_MainThreadHead = 0;
+    std::mutex m_MainThreadMutex;
+    // Finished jobs, reused so submitting does not allocate.
+    std::vector<Job *> m_FreeJobs;
+    std::mutex m_FreeJobsMutex;
+
+    // Jobs queued for any thread but not yet taken, so idle workers know when to wake.
+    std::atomic<int> m_Queued{ 0 };
+    std::atomic<int> m_Sleeping{ 0 };
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCondition;
+    bool m_Stopping = false;
+
+    ProfileHook m_ProfileHook;
+public:
+    // Starts thread_count workers, or one per core but the main thread when
+    // 0. Call on the main thread.
+    void Init(unsigned int thread_count = 0);
+    // Runs whatever is still queued, then stops the workers.
+    void Shutdown();
+
+    // The job runs on any thread. counter, if given, is held above zero until it is done.
+    void Submit(std::function<void()> function, JobCounter *counter = nullptr, const char *name = "Job");
+    // As Submit, but the job is queued only once dependency reaches zero.
+    void SubmitAfter(JobCounter &dependency, std::function<void()> function, JobCounter *counter = nullptr, const char *name = "Job");
+    // The job runs on the main thread, from RunMainThreadJobs or while the main thread waits.
+    void SubmitMainThread(std::function<void()> function, JobCounter *counter = nullptr, const char *name = "Job");
+    // Splits [begin, end) into ranges of at least grain indices, runs body on
+    // each in parallel and returns once all of them are done.
+    void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &body, const char *name = "ParallelFor");
+
+    // Hold a counter above zero for work that is not a single job, and let it go again.
+    void Retain(JobCounter &counter);
+    void Release(JobCounter &counter);
+
+    // Runs other jobs until counter reaches zero, so a job can wait on work
+    // it submitted without stalling a worker. Without help the main thread
+    // only runs main-thread jobs and leaves the rest to the workers, so it is
+    // free the moment GL work becomes ready.
+    void Wait(JobCounter &counter, bool help = true);
+    // Call once per frame on the main thread.
+    void RunMainThreadJobs();
+
+    // Set while no jobs are running. Called from every thread.
+    inline void SetProfileHook(ProfileHook hook) { m_ProfileHook = std::move(hook); }
+    inline unsigned int GetThreadCount() const { return (unsigned int)m_Threads.size(); }
+private:
+    Job *NewJob(std::function<void()> &&function, JobCounter *counter, const char *name, bool main_thread);
+    void Schedule(Job *job);
+    void Enqueue(Job *job);
+    Job *FindJob(int worker);
+    Job *TakeMainThreadJob();
+    void Execute(Job *job, int worker);
+    void WorkerLoop(int worker);
+};
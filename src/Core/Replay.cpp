@@ -0,0 +1,279 @@
+#include "Replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL.h>
+
+template<typename T>
+void Replay::Put(const T &value)
+{
+    const size_t size = m_Buffer.size();
+    m_Buffer.resize(size + sizeof(T));
+    memcpy(m_Buffer.data() + size, &value, sizeof(T));
+}
+
+// Reads a T at offset and advances it; false if the data ends first.
+template<typename T>
+static bool Take(const std::vector<uint8_t> &data, size_t &offset, T &value)
+{
+    if(offset + sizeof(T) > data.size()) return false;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+bool Replay::StartRecording(const std::string &path)
+{
+    m_File.open(path, std::ios::binary | std::ios::trunc);
+    if(!m_File)
+    {
+        SDL_Log("Cannot write replay %s\n", path.c_str());
+        return false;
+    }
+    m_Buffer.clear();
+    Put(MAGIC);
+    Put(VERSION);
+    m_Mode = Mode::Record;
+    return true;
+}
+
+bool Replay::StartPlayback(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if(!stream)
+    {
+        SDL_Log("Cannot read replay %s\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> data((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char *)data.data(), data.size());
+
+    size_t offset = 0;
+    uint32_t magic = 0, version = 0;
+    if(!Take(data, offset, magic) || !Take(data, offset, version) || magic != MAGIC || version < 1 || version > VERSION)
+    {
+        SDL_Log("%s is not a replay this version can play\n", path.c_str());
+        return false;
+    }
+
+    m_FrameDeltas.clear();
+    m_Events.clear();
+    m_Resizes.clear();
+    for(uint8_t type; Take(data, offset, type);)
+    {
+        bool complete = true;
+        if(type == (uint8_t)RecordType::Frame)
+        {
+            float delta;
+            complete = Take(data, offset, delta);
+            if(complete)
+                m_FrameDeltas.push_back(delta);
+        }
+        else if(type == (uint8_t)RecordType::Event)
+        {
+            uint32_t tick;
+            uint16_t tick_offset;
+            uint8_t event_type, state;
+            int16_t code;
+            complete = Take(data, offset, tick) && Take(data, offset, tick_offset)
+                && Take(data, offset, event_type) && Take(data, offset, state) && Take(data, offset, code);
+            InputEvent event = { (InputEvent::Type)event_type, state != 0, code };
+            if(complete && event.type == InputEvent::Type::MouseMotion)
+            {
+                int16_t motion[4];
+                complete = Take(data, offset, motion);
+                event.x = motion[0];
+                event.y = motion[1];
+                event.relx = motion[2];
+                event.rely = motion[3];
+            }
+            if(complete)
+                m_Events.push_back(TickEvent{ tick, tick_offset, event });
+        }
+        else if(type == (uint8_t)RecordType::Resize)
+        {
+            uint32_t frame;
+            int32_t size[2];
+            complete = Take(data, offset, frame) && Take(data, offset, size);
+            if(complete)
+                m_Resizes.push_back(Resize{ frame, size[0], size[1] });
+        }
+        else
+            complete = false;
+        // A crashed recording ends mid-record; play what came before.
+        if(!complete)
+        {
+            SDL_Log("Replay %s is truncated\n", path.c_str());
+            break;
+        }
+    }
+    // The simulation thread records events in tick order, but ties with
+    // frames interleave, so make sure.
+    std::stable_sort(m_Events.begin(), m_Events.end(), [](const TickEvent &a, const TickEvent &b) { return a.tick < b.tick; });
+
+    m_NextFrame = m_NextEvent = m_NextResize = 0;
+    m_FrameTimes.clear();
+    m_FrameTimes.reserve(m_FrameDeltas.size());
+    m_Mode = Mode::Play;
+    SDL_Log("Playing %u frames and %u events from %s\n", (unsigned int)m_FrameDeltas.size(), (unsigned int)m_Events.size(), path.c_str());
+    return true;
+}
+
+void Replay::Finish()
+{
+    if(m_Mode == Mode::Record)
+    {
+        std::lock_guard<std::mutex> lock(m_BufferMutex);
+        Flush();
+        m_File.close();
+    }
+    else if(m_Mode == Mode::Play && m_NextEvent < m_Events.size())
+        SDL_Log("Replay ended with %u events not played\n", (unsigned int)(m_Events.size() - m_NextEvent));
+    m_Mode = Mode::Off;
+}
+
+bool Replay::NextFrame(float &delta)
+{
+    if(m_Mode == Mode::Record)
+    {
+        std::lock_guard<std::mutex> lock(m_BufferMutex);
+        Put(RecordType::Frame);
+        Put(delta);
+        if(m_Buffer.size() >= FLUSH_SIZE)
+            Flush();
+        return true;
+    }
+    if(m_Mode != Mode::Play) return true;
+    if(m_NextFrame >= m_FrameDeltas.size()) return false;
+    delta = m_FixedDelta > 0.0f ? m_FixedDelta : m_FrameDeltas[m_NextFrame];
+    m_NextFrame++;
+    return true;
+}
+
+void Replay::RecordEvent(uint64_t tick, uint16_t offset, const InputEvent &event)
+{
+    std::lock_guard<std::mutex> lock(m_BufferMutex);
+    Put(RecordType::Event);
+    Put((uint32_t)tick);
+    Put(offset);
+    Put((uint8_t)event.type);
+    Put((uint8_t)event.state);
+    Put((int16_t)event.code);
+    // Only motion carries coordinates; window-sized values fit in 16 bits.
+    if(event.type == InputEvent::Type::MouseMotion)
+    {
+        const int16_t motion[4] = { (int16_t)event.x, (int16_t)event.y, (int16_t)event.relx, (int16_t)event.rely };
+        Put(motion);
+    }
+}
+
+void Replay::RecordResize(uint64_t frame, int width, int height)
+{
+    if(m_Mode != Mode::Record) return;
+    std::lock_guard<std::mutex> lock(m_BufferMutex);
+    Put(RecordType::Resize);
+    Put((uint32_t)frame);
+    const int32_t size[2] = { width, height };
+    Put(size);
+}
+
+bool Replay::NextResize(uint64_t frame, int &width, int &height)
+{
+    if(m_Mode != Mode::Play || m_NextResize >= m_Resizes.size() || m_Resizes[m_NextResize].frame > frame)
+        return false;
+    width = m_Resizes[m_NextResize].width;
+    height = m_Resizes[m_NextResize].height;
+    m_NextResize++;
+    return true;
+}
+
+const Replay::TickEvent *Replay::NextEvent(uint64_t tick)
+{
+    if(m_NextEvent >= m_Events.size() || m_Events[m_NextEvent].tick > tick)
+        return nullptr;
+    return &m_Events[m_NextEvent++];
+}
+
+Replay::FrameStats Replay::GetFrameStats() const
+{
+    FrameStats stats;
+    if(m_FrameTimes.empty()) return stats;
+    std::vector<float> sorted = m_FrameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))] * 1000.0;
+    };
+    double sum = 0.0;
+    for(float time : sorted)
+        sum += time;
+    stats.frames = (unsigned int)sorted.size();
+    stats.mean = sum / sorted.size() * 1000.0;
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = sorted.back() * 1000.0;
+    return stats;
+}
+
+bool Replay::SaveBaseline(const std::string &path) const
+{
+    const FrameStats stats = GetFrameStats();
+    std::ofstream stream(path);
+    stream << "frames " << stats.frames << "\n"
+           << "mean " << stats.mean << "\n"
+           << "p50 " << stats.p50 << "\n"
+           << "p95 " << stats.p95 << "\n"
+           << "p99 " << stats.p99 << "\n"
+           << "max " << stats.max << "\n";
+    if(!stream)
+    {
+        SDL_Log("Cannot write baseline %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Replay::CompareBaseline(const std::string &path, float tolerance) const
+{
+    std::ifstream stream(path);
+    if(!stream)
+    {
+        SDL_Log("Cannot read baseline %s\n", path.c_str());
+        return false;
+    }
+    FrameStats baseline;
+    std::string key;
+    for(double value; stream >> key >> value;)
+    {
+        if(key == "frames") baseline.frames = (unsigned int)value;
+        else if(key == "mean") baseline.mean = value;
+        else if(key == "p50") baseline.p50 = value;
+        else if(key == "p95") baseline.p95 = value;
+        else if(key == "p99") baseline.p99 = value;
+        else if(key == "max") baseline.max = value;
+    }
+
+    const FrameStats stats = GetFrameStats();
+    SDL_Log("Frame times over %u frames against %u in %s:\n", stats.frames, baseline.frames, path.c_str());
+    bool passed = true;
+    auto compare = [&passed, tolerance](const char *name, double current, double base, bool gate) {
+        const double change = base > 0.0 ? (current / base - 1.0) * 100.0 : 0.0;
+        const bool regressed = gate && current > base * (1.0 + tolerance);
+        SDL_Log("  %-4s %8.2f ms  baseline %8.2f ms  %+6.1f%%%s\n", name, current, base, change, regressed ? "  REGRESSED" : "");
+        passed &= !regressed;
+    };
+    compare("mean", stats.mean, baseline.mean, true);
+    compare("p50", stats.p50, baseline.p50, false);
+    compare("p95", stats.p95, baseline.p95, true);
+    compare("p99", stats.p99, baseline.p99, true);
+    compare("max", stats.max, baseline.max, false);
+    return passed;
+}
+
+void Replay::Flush()
+{
+    m_File.write((const char *)m_Buffer.data(), m_Buffer.size());
+    m_Buffer.clear();
+}
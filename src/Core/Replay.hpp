@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Input.hpp"
+#include "../Singleton.hpp"
+
+// Records a session's input and frame deltas to a compact binary log and
+// plays it back, so a performance problem seen in real play can be
+// captured again exactly. Events are stored with the simulation tick that
+// applied them and where in the tick they fell, so playback drives the
+// simulation the same way whatever timestep the frames use. Window sizes
+// are stored with the frame that saw them, since they change what is drawn,
+// and playback sizes the window from the log alone. The frame times
+// of a playback can be saved as a baseline or compared against one.
+class Replay
+{
+    SINGLETON(Replay);
+public:
+    enum class Mode { Off, Record, Play };
+    // Frame times of a playback, in milliseconds.
+    struct FrameStats
+    {
+        unsigned int frames = 0;
+        double mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+    };
+    // An event as the simulation applies it. offset is the position within
+    // the tick in 65536ths.
+    struct TickEvent
+    {
+        uint64_t tick;
+        uint16_t offset;
+        InputEvent event;
+    };
+private:
+    static constexpr uint32_t MAGIC = 0x50524B49; // "IKRP"
+    // Version 1 logs lack window sizes and play back at the default size.
+    static constexpr uint32_t VERSION = 2;
+    static constexpr size_t FLUSH_SIZE = 64 * 1024;
+    enum class RecordType : uint8_t { Frame, Event, Resize };
+    struct Resize
+    {
+        uint64_t frame;
+        int width, height;
+    };
+
+    Mode m_Mode = Mode::Off;
+
+    // Frames are recorded on the main thread and events on the simulation
+    // thread, into one buffer that is written out as it fills.
+    std::ofstream m_File;
+    std::vector<uint8_t> m_Buffer;
+    std::mutex m_BufferMutex;
+
+    std::vector<float> m_FrameDeltas;
+    size_t m_NextFrame = 0;
+    std::vector<TickEvent> m_Events;
+    size_t m_NextEvent = 0;
+    std::vector<Resize> m_Resizes;
+    size_t m_NextResize = 0;
+    float m_FixedDelta = 0.0f;
+    std::vector<float> m_FrameTimes;
+public:
+    bool StartRecording(const std::string &path);
+    bool StartPlayback(const std::string &path);
+    // Writes out the rest of a recording. Call once the simulation has stopped.
+    void Finish();
+    inline Mode GetMode() const { return m_Mode; }
+    inline bool IsRecording() const { return m_Mode == Mode::Record; }
+    inline bool IsPlaying() const { return m_Mode == Mode::Play; }
+    // Plays every frame back with this delta instead of the recorded one; 0 restores those.
+    inline void SetFixedDelta(float delta) { m_FixedDelta = delta; }
+
+    // Main thread, once a frame. Records the frame's delta, or in playback
+    // replaces it with the next one from the log. Returns false once the log is over.
+    bool NextFrame(float &delta);
+    // Simulation thread, for each event it applies while recording.
+    void RecordEvent(uint64_t tick, uint16_t offset, const InputEvent &event);
+    // In playback, the next event due by the given tick, or nullptr. Events
+    // for earlier ticks are returned late rather than dropped.
+    const TickEvent *NextEvent(uint64_t tick);
+    // Main thread. Records the window size a frame saw, including the size it starts at.
+    void RecordResize(uint64_t frame, int width, int height);
+    // In playback, the next window size due by the given frame. Returns false if there is none.
+    bool NextResize(uint64_t frame, int &width, int &height);
+
+    // Real seconds a frame took during playback.
+    inline void AddFrameTime(float seconds) { m_FrameTimes.push_back(seconds); }
+    FrameStats GetFrameStats() const;
+    bool SaveBaseline(const std::string &path) const;
+    // Logs the frame times next to the baseline's. Returns false if the
+    // mean, 95th or 99th percentile is more than tolerance slower.
+    bool CompareBaseline(const std::string &path, float tolerance = 0.1f) const;
+private:
+    template<typename T>
+    void Put(const T &value);
+    void Flush();
+};
@@ -0,0 +1,156 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+#include "AllocationTracker.hpp"
+#include "Replay.hpp"
+
+bool Simulation::Start(float ticks_per_second, TickFunction tick)
+{
+    m_Timestep.SetRate(ticks_per_second);
+    m_Tick = std::move(tick);
+    m_LastUpdate = 0;
+    m_TickCount = 0;
+    m_Playback = Replay::Get().IsPlaying();
+    m_Clock = SDL_GetPerformanceCounter();
+    // Playback must tick the same way on every run, which a thread on the real clock would not.
+    if(m_Playback)
+        return false;
+#ifdef __EMSCRIPTEN__
+    // Without pthreads the main loop ticks the simulation itself.
+    return false;
+#else
+    m_Running = true;
+    m_Thread = std::thread(&Simulation::Run, this);
+    return true;
+#endif
+}
+
+void Simulation::Stop()
+{
+    if(!m_Thread.joinable()) return;
+    m_Running = false;
+    m_Thread.join();
+}
+
+void Simulation::PushEvent(InputEvent event)
+{
+    event.timestamp = SDL_GetPerformanceCounter();
+    if(m_Events.Push(event)) return;
+    // The simulation has stalled for thousands of events; losing some beats blocking the event pump.
+    if(!m_DroppedEvents++)
+        SDL_Log("Input queue full, dropping events.\n");
+}
+
+void Simulation::Update(float frame_delta)
+{
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 now;
+    float delta;
+    if(m_Playback)
+    {
+        now = m_Clock.load() + (Uint64)(frame_delta * frequency);
+        m_Clock.store(now);
+        delta = frame_delta;
+        // Live input would make the run differ from the recording.
+        while(m_Events.Front())
+            m_Events.Pop();
+    }
+    else
+    {
+        now = SDL_GetPerformanceCounter();
+        if(!m_LastUpdate)
+            m_LastUpdate = now;
+        delta = (float)(now - m_LastUpdate) / frequency;
+        m_LastUpdate = now;
+    }
+    const unsigned int ticks = m_Timestep.Advance(delta);
+    if(!ticks) return;
+
+    // The ticks just added end one step apart, the last where the time left
+    // over in the accumulator begins.
+    const Uint64 step = (Uint64)(m_Timestep.GetStep() * frequency);
+    Uint64 tick_end = now - (Uint64)(m_Timestep.GetAlpha() * step) - (ticks - 1) * step;
+
+    Input &input = Input::Get();
+    Replay &replay = Replay::Get();
+    Uint64 latest = 0;
+    for(unsigned int i = 0; i < ticks; i++, tick_end += step, m_TickCount++)
+    {
+        const Uint64 tick_start = tick_end - step;
+        input.BeginTick(tick_start, tick_end);
+        if(m_Playback)
+        {
+            while(const Replay::TickEvent *recorded = replay.NextEvent(m_TickCount))
+            {
+                InputEvent event = recorded->event;
+                event.timestamp = tick_start + recorded->offset * step / 65536;
+                input.HandleEvent(event);
+            }
+        }
+        while(const InputEvent *event = m_Events.Front())
+        {
+            // Later events belong to a later tick.
+            if(event->timestamp >= tick_end) break;
+            // Times are rounded to where a replay can put them, so playback
+            // reproduces held fractions exactly.
+            const Uint64 offset = std::min<Uint64>(event->timestamp > tick_start ? (event->timestamp - tick_start) * 65536 / step : 0, 65535);
+            InputEvent applied = *event;
+            applied.timestamp = tick_start + offset * step / 65536;
+            input.HandleEvent(applied);
+            latest = std::max(latest, event->timestamp);
+            if(replay.IsRecording())
+                replay.RecordEvent(m_TickCount, (uint16_t)offset, applied);
+            m_Events.Pop();
+        }
+        m_Tick(m_Timestep.GetStep(), tick_end);
+        input.Tick();
+    }
+    if(latest)
+        m_LatestApplied.store(latest, std::memory_order_release);
+}
+
+float Simulation::GetAlpha(Uint64 tick_end) const
+{
+    const Uint64 now = m_Playback ? m_Clock.load() : SDL_GetPerformanceCounter();
+    if(now <= tick_end) return 0.0f;
+    return std::min(1.0f, (float)(now - tick_end) / (m_Timestep.GetStep() * SDL_GetPerformanceFrequency()));
+}
+
+void Simulation::OnFramePresented()
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    if(!m_ReportStart)
+        m_ReportStart = now;
+
+    const Uint64 latest = m_LatestApplied.load(std::memory_order_acquire);
+    if(latest > m_LastMeasured)
+    {
+        const double latency = (now - latest) / frequency;
+        m_LatencySum += latency;
+        m_LatencyMax = std::max(m_LatencyMax, latency);
+        m_LatencyCount++;
+        m_LastMeasured = latest;
+    }
+
+    if((now - m_ReportStart) / frequency < LATENCY_REPORT_INTERVAL) return;
+    if(m_LatencyCount)
+        SDL_Log("Input to present: %.1f ms average, %.1f ms worst over %u inputs\n",
+            m_LatencySum / m_LatencyCount * 1000.0, m_LatencyMax * 1000.0, m_LatencyCount);
+    m_ReportStart = now;
+    m_LatencySum = m_LatencyMax = 0.0;
+    m_LatencyCount = 0;
+}
+
+void Simulation::Run()
+{
+    AllocationTracker::SetThreadName("Simulation");
+    while(m_Running.load())
+    {
+        Update();
+        // Events that arrive while asleep wait in the queue for the tick they fall in.
+        const float remaining = (1.0f - m_Timestep.GetAlpha()) * m_Timestep.GetStep();
+        SDL_Delay(std::max(1u, (Uint32)(remaining * 1000.0f)));
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <SDL.h>
+
+#include "FixedTimestep.hpp"
+#include "SpscQueue.hpp"
+#include "../Input.hpp"
+#include "../Singleton.hpp"
+
+// Runs the game's fixed-rate ticks on a thread of their own, so a slow frame
+// delays neither input handling nor physics. The main thread keeps pumping
+// SDL events and passes input on, timestamped, through a lock-free queue;
+// each tick applies exactly the events that happened before its end. Where
+// there are no threads, or while a replay plays, Update is called once a
+// frame instead.
+class Simulation
+{
+    SINGLETON(Simulation);
+public:
+    // Runs one tick. tick_end is the performance counter time the tick
+    // simulates up to, for interpolating between ticks when rendering.
+    typedef std::function<void(float step, Uint64 tick_end)> TickFunction;
+private:
+    static constexpr size_t EVENT_QUEUE_SIZE = 4096;
+    static constexpr float LATENCY_REPORT_INTERVAL = 5.0f;
+
+    SpscQueue<InputEvent> m_Events{ EVENT_QUEUE_SIZE };
+    FixedTimestep m_Timestep;
+    TickFunction m_Tick;
+    Uint64 m_LastUpdate = 0;
+    uint64_t m_TickCount = 0;
+    // During playback time advances by the frame deltas alone.
+    bool m_Playback = false;
+    std::atomic<Uint64> m_Clock{ 0 };
+
+    std::thread m_Thread;
+    std::atomic<bool> m_Running{ false };
+    // Timestamp of the newest event a tick has applied.
+    std::atomic<Uint64> m_LatestApplied{ 0 };
+
+    // Main thread only.
+    unsigned int m_DroppedEvents = 0;
+    Uint64 m_LastMeasured = 0;
+    Uint64 m_ReportStart = 0;
+    double m_LatencySum = 0.0;
+    double m_LatencyMax = 0.0;
+    unsigned int m_LatencyCount = 0;
+public:
+    // Starts ticking ticks_per_second times a second. Returns false if the
+    // ticks were not given a thread, in which case call Update every frame.
+    bool Start(float ticks_per_second, TickFunction tick);
+    void Stop();
+    inline bool IsThreaded() const { return m_Thread.joinable(); }
+    inline float GetStep() const { return m_Timestep.GetStep(); }
+
+    // Main thread only. Stamps the event with the current time and queues it for the next tick.
+    void PushEvent(InputEvent event);
+    // Runs the ticks that are due by the clock, or during replay playback
+    // those that frame_delta adds up to. Called by the simulation thread
+    // itself when there is one.
+    void Update(float frame_delta = 0.0f);
+    // How far the time now is past the end of a tick, in steps from 0 to 1, for interpolation.
+    float GetAlpha(Uint64 tick_end) const;
+    // Call on the main thread once a frame is presented; measures and
+    // periodically logs how long input takes to reach the screen.
+    void OnFramePresented();
+private:
+    void Run();
+};
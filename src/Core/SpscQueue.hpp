@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer
+// thread. Each side keeps a copy of the other's index and only rereads it
+// when the copy says the queue is full or empty, so in the common case
+// neither touches the other's cache line.
+template<typename T>
+class SpscQueue
+{
+private:
+    std::unique_ptr<T[]> m_Buffer;
+    size_t m_Mask;
+    alignas(64) std::atomic<size_t> m_Head{ 0 };
+    size_t m_CachedTail = 0;
+    alignas(64) std::atomic<size_t> m_Tail{ 0 };
+    size_t m_CachedHead = 0;
+public:
+    // capacity must be a power of two.
+    explicit SpscQueue(size_t capacity)
+        : m_Buffer(new T[capacity]), m_Mask(capacity - 1)
+    {
+    }
+
+    // Producer only. Returns false if the queue is full.
+    bool Push(const T &item)
+    {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if(tail - m_CachedHead > m_Mask)
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if(tail - m_CachedHead > m_Mask)
+                return false;
+        }
+        m_Buffer[tail & m_Mask] = item;
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. The oldest item, or nullptr if the queue is empty.
+    T *Front()
+    {
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        if(head == m_CachedTail)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if(head == m_CachedTail)
+                return nullptr;
+        }
+        return &m_Buffer[head & m_Mask];
+    }
+
+    // Consumer only. Drops the item Front returned.
+    void Pop()
+    {
+        m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
@@ -0,0 +1,55 @@
+#include "StartupReport.hpp"
+
+#include <algorithm>
+
+#include <SDL_log.h>
+#include <SDL_timer.h>
+
+StartupReport::Scope::Scope(const std::string &name, bool worker)
+    : m_Name(name), m_Start(SDL_GetPerformanceCounter()), m_Worker(worker)
+{
+}
+
+StartupReport::Scope::~Scope()
+{
+    StartupReport::Get().Record(m_Name, m_Start, SDL_GetPerformanceCounter(), m_Worker);
+}
+
+void StartupReport::Start()
+{
+    m_Origin = SDL_GetPerformanceCounter();
+}
+
+void StartupReport::Record(const std::string &name, Uint64 start, Uint64 end, bool worker)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if(m_Finished) return;
+    m_Phases.push_back(Phase{ name, start, end, worker });
+}
+
+void StartupReport::Finish()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if(m_Finished) return;
+    m_Finished = true;
+
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const double to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+
+    std::stable_sort(m_Phases.begin(), m_Phases.end(), [](const Phase &a, const Phase &b) { return a.start < b.start; });
+
+    SDL_Log("Startup report (ms, start + duration):\n");
+    double worker_total = 0.0;
+    for(const Phase &phase : m_Phases)
+    {
+        const double start = (phase.start - m_Origin) * to_ms;
+        const double duration = (phase.end - phase.start) * to_ms;
+        if(phase.worker) worker_total += duration;
+        SDL_Log("  %8.2f + %8.2f  %s%s\n", start, duration, phase.worker ? "[worker] " : "", phase.name.c_str());
+    }
+    SDL_Log("  worker time: %.2f ms\n", worker_total);
+    SDL_Log("  time to first frame: %.2f ms\n", (now - m_Origin) * to_ms);
+
+    m_Phases.clear();
+    m_Phases.shrink_to_fit();
+}
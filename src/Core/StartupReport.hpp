@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <SDL_stdinc.h>
+
+#include "../Singleton.hpp"
+
+// Collects timings from launch to the first presented frame and logs them
+// once as a per-phase report. Safe to record from worker threads.
+class StartupReport
+{
+    SINGLETON(StartupReport);
+private:
+    struct Phase
+    {
+        std::string name;
+        Uint64 start, end;
+        bool worker;
+    };
+    std::vector<Phase> m_Phases;
+    std::mutex m_Mutex;
+    Uint64 m_Origin = 0;
+    bool m_Finished = false;
+public:
+    class Scope
+    {
+    private:
+        std::string m_Name;
+        Uint64 m_Start;
+        bool m_Worker;
+    public:
+        Scope(const std::string &name, bool worker = false);
+        ~Scope();
+    };
+public:
+    void Start();
+    void Record(const std::string &name, Uint64 start, Uint64 end, bool worker = false);
+    // Logs the report the first time it is called; later calls do nothing.
+    void Finish();
+    inline bool IsFinished() const { return m_Finished; }
+};
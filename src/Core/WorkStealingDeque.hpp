@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Chase-Lev deque with the memory ordering from Lê et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models". The owning thread pushes
+// and pops at the bottom; any other thread may steal from the top.
+// The capacity is fixed, and Push fails rather than grow when it is full.
+template<typename T>
+class WorkStealingDeque
+{
+private:
+    static_assert(std::is_pointer<T>::value, "WorkStealingDeque holds pointers");
+    // Apart so the owner and the thieves do not share a cache line.
+    alignas(64) std::atomic<int64_t> m_Top{ 0 };
+    alignas(64) std::atomic<int64_t> m_Bottom{ 0 };
+    std::unique_ptr<std::atomic<T>[]> m_Buffer;
+    int64_t m_Mask;
+public:
+    // capacity must be a power of two.
+    explicit WorkStealingDeque(int64_t capacity)
+        : m_Buffer(new std::atomic<T>[capacity]), m_Mask(capacity - 1)
+    {
+    }
+
+    // Owner only.
+    bool Push(T item)
+    {
+        const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_Top.load(std::memory_order_acquire);
+        if(bottom - top > m_Mask)
+            return false;
+        m_Buffer[bottom & m_Mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only. Takes the most recently pushed item, or returns nullptr.
+    T Pop()
+    {
+        const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_Top.load(std::memory_order_relaxed);
+
+        if(top > bottom)
+        {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T item = m_Buffer[bottom & m_Mask].load(std::memory_order_relaxed);
+        if(top == bottom)
+        {
+            // The last item: race the thieves for it.
+            if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread. Takes the oldest item, or returns nullptr if the deque is
+    // empty or another thread got there first.
+    T Steal()
+    {
+        int64_t top = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+        if(top >= bottom)
+            return nullptr;
+        T item = m_Buffer[top & m_Mask].load(std::memory_order_relaxed);
+        if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+};
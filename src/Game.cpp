@@ -1,30 +1,148 @@
 #include "Game.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+
 #include <glm/gtc/constants.hpp>
 #include <box2d/box2d.h>
 #include <entt/entt.hpp>
 
 #include "Input.hpp"
+#include "Core/AllocationTracker.hpp"
 #include "Render/Renderer.hpp"
 #include "Render/Texture.hpp"
+#include "Render/TextLayout.hpp"
+#include "Render/TextConsole.hpp"
+#include "Resource/ResourceManager.hpp"
 #include "Component/Transform2D.hpp"
+#include "Core/FramePacer.hpp"
+#include "Core/FrameGraph.hpp"
+#include "Core/Simulation.hpp"
+#include "Core/FrameArena.hpp"
+#include "Physics/PhysicsWorld.hpp"
 
-static b2World *world;
 static b2Body *groundBody;
 static b2Body *body;
-static int32 velocityIterations = 8;
-static int32 positionIterations = 3;
+static uint32_t groundSlot;
+static uint32_t bodySlot;
+// Physics and game logic run at this rate whatever the display refresh rate is.
+static const float ticksPerSecond = 60.0f;
+// Body transforms as of the last two ticks, for interpolation. Only the
+// animation stage touches them, and it runs one frame at a time.
+static PhysicsWorld::Transforms bodyTransforms;
+// Event log lines from the simulation, added to the console when drawn.
+// Fixed-size and reserved up front, so a tick can queue one without the heap.
+struct LogLine
+{
+    char text[64];
+};
+static std::vector<LogLine> pendingLog;
+static std::mutex pendingLogMutex;
+// Mouse wheel movement the ticks have applied since the last drawn frame.
+// The wheel goes through the simulation like other input, so a replay
+// scrolls the log the same way.
+static std::atomic<int> logScroll{ 0 };
+static Input::Action jumpAction;
+static Input::Action moveLeftAction;
+static Input::Action moveRightAction;
+
+// One quad of the scene. The animation stage builds them, culling and
+// batching pick and order them, and the submit stage draws them.
+struct Sprite
+{
+    enum class Type : uint8_t { Quad, Texture, SubTexture };
+    Type type;
+    // Drawn in layer order. Within a layer sprites are grouped by texture, so
+    // sprites that overlap each other need layers of their own.
+    uint8_t layer;
+    TextureHandle texture;
+    SubTextureHandle subTexture;
+    // Half the quad's size before the transform, for culling.
+    glm::vec2 extent;
+    glm::mat4 transform;
+    glm::vec4 color;
+};
+// What one frame passes from its animation stage to its submit stage.
+// Double buffered, so the next frame can fill one while this frame's is
+// drawn. The lists live in the frame's arena: the animation stage creates
+// them and the submit stage drops them before RenderEnd.
+struct SceneBuffer
+{
+    ArenaVector<Sprite> sprites;
+    ArenaVector<uint32_t> visible;
+    SceneBuffer(std::pmr::memory_resource *memory) : sprites(memory), visible(memory) {}
+};
+static std::array<std::optional<SceneBuffer>, 2> scenes;
+
+static TextureHandle rotatingTexture;
+static TextureHandle backgroundTexture;
+static TextureHandle subTextureTest0;
+static SubTextureHandle subTextureTest1;
+static SubTextureHandle subTextureTest2;
+static FontHandle robotoFont;
+static FontHandle robotoDistanceField;
+static TextLayout titleText;
+static TextLayout subtitleText;
+static TextLayout fpsText;
+static TextConsole eventLog;
+// Sprite sizes are read once at Init so culling never touches the resource manager off the main thread.
+static glm::vec2 backgroundSize, rotatingSize, subTextureTestSizes[3];
+
+static const char *rotatingTexturePath   = "asset/image/rotating.png";
+static const char *backgroundTexturePath = "asset/image/background.png";
+static const char *subTextureTestPath    = "asset/image/subtexturetest.png";
+static const char *robotoFontPath        = "asset/font/Roboto/Roboto-Regular.ttf";
+static const int robotoFontSize = 34;
+
+void Game::Preload()
+{
+    ResourceManager &resources = ResourceManager::Get();
+    resources.PrefetchTexture(rotatingTexturePath);
+    resources.PrefetchTexture(backgroundTexturePath);
+    resources.PrefetchTexture(subTextureTestPath);
+    resources.PrefetchFont(robotoFontPath, robotoFontSize);
+    resources.PrefetchFont(robotoFontPath, Font::DISTANCE_FIELD_SIZE, Font::Rendering::DistanceField);
+}
 
 void Game::Init(SDL_Window *pWindow)
 {
     m_pWindow = pWindow;
 
-    b2Vec2 gravity(0.0f, -10.0f);
-    world = new b2World(gravity);
+    ResourceManager &resources = ResourceManager::Get();
+    rotatingTexture   = resources.LoadTexture(rotatingTexturePath);
+    backgroundTexture = resources.LoadTexture(backgroundTexturePath);
+    subTextureTest0   = resources.LoadTexture(subTextureTestPath);
+    subTextureTest1   = resources.CreateSubTexture(subTextureTest0, 100, 100, 900, 900);
+    subTextureTest2   = resources.CreateSubTexture(subTextureTest1, 100, 100, 800, 800);
+    robotoFont        = resources.LoadFont(robotoFontPath, robotoFontSize);
+    robotoDistanceField = resources.LoadFont(robotoFontPath, Font::DISTANCE_FIELD_SIZE, Font::Rendering::DistanceField);
+
+    auto size_of = [](const Texture *texture) {
+        return texture ? glm::vec2(texture->GetWidth(), texture->GetHeight()) : glm::vec2(0.0f);
+    };
+    backgroundSize = size_of(resources.GetTexture(backgroundTexture));
+    rotatingSize = size_of(resources.GetTexture(rotatingTexture));
+    subTextureTestSizes[0] = size_of(resources.GetTexture(subTextureTest0));
+    subTextureTestSizes[1] = size_of(resources.GetSubTexture(subTextureTest1));
+    subTextureTestSizes[2] = size_of(resources.GetSubTexture(subTextureTest2));
+
+    titleText = TextLayout(robotoDistanceField, 64.0f, "Isker");
+    subtitleText = TextLayout(robotoDistanceField, 20.0f, "Distance-field text");
+    fpsText.SetFont(robotoFont);
+    fpsText.SetAlignment(Renderer::TextHAlign::Left, Renderer::TextVAlign::Bottom);
+    eventLog = TextConsole(robotoFont, 16.0f, glm::vec2(360.0f, 120.0f));
+    eventLog.AddParagraph("Space jumps, arrow keys move. Scroll this log with the mouse wheel.");
+    pendingLog.reserve(16);
+
+    PhysicsWorld::Get().Init(b2Vec2(0.0f, -10.0f));
+    b2World &world = PhysicsWorld::Get().GetWorld();
 
     b2BodyDef groundBodyDef;
     groundBodyDef.position.Set(0.0f, -10.0f);
-    groundBody = world->CreateBody(&groundBodyDef);
+    groundBody = world.CreateBody(&groundBodyDef);
     b2PolygonShape groundBox;
     groundBox.SetAsBox(50.0f, 10.0f);
     groundBody->CreateFixture(&groundBox, 0.0f);
@@ -33,7 +151,7 @@ void Game::Init(SDL_Window *pWindow)
     bodyDef.type = b2_dynamicBody;
     bodyDef.position.Set(0.0f, 7.0f);
     bodyDef.angle = glm::pi<float>() / 3.0f;
-    body = world->CreateBody(&bodyDef);
+    body = world.CreateBody(&bodyDef);
     b2PolygonShape dynamicBox;
     dynamicBox.SetAsBox(1.0f, 1.0f);
     b2FixtureDef fixtureDef;
@@ -41,23 +159,80 @@ void Game::Init(SDL_Window *pWindow)
     fixtureDef.density = 1.0f;
     fixtureDef.friction = 0.3f;
     body->CreateFixture(&fixtureDef);
+    groundSlot = PhysicsWorld::Get().AddBody(groundBody);
+    bodySlot = PhysicsWorld::Get().AddBody(body);
+
+    Input &input = Input::Get();
+    jumpAction = input.AddAction("Jump", { SDL_SCANCODE_SPACE });
+    moveLeftAction = input.AddAction("MoveLeft", { SDL_SCANCODE_LEFT, SDL_SCANCODE_A });
+    moveRightAction = input.AddAction("MoveRight", { SDL_SCANCODE_RIGHT, SDL_SCANCODE_D });
+
+    // From here on only ticks touch the world and the input actions;
+    // anything else goes through PhysicsWorld's command queue.
+    Simulation::Get().Start(ticksPerSecond, Tick);
+}
+
+void Game::BuildFrameGraph(FrameGraph &graph)
+{
+    // These live in the double-buffered SceneBuffer.
+    graph.AddResource("Scene", 2);
+    graph.AddResource("Visible", 2);
+    // Without a simulation thread the frame runs the ticks that are due first.
+    if(!Simulation::Get().IsThreaded())
+        graph.AddStage("Simulate", {}, { "Bodies" }, [](const FrameGraph::FrameInfo &frame) { Simulation::Get().Update(frame.delta); });
+    graph.AddStage("Animate", { "Bodies" }, { "Scene" }, Animate);
+    graph.AddStage("Cull", { "Scene" }, { "Visible" }, Cull);
+    graph.AddStage("Batch", { "Scene" }, { "Visible" }, Batch);
+    graph.AddStage("Submit", { "Scene", "Visible", "Assets" }, { "Log" }, Submit, FrameGraph::Affinity::MainThread);
 }
 
-void Game::Frame(float delta)
+void Game::Tick(float step, Uint64 tick_end)
 {
-    static std::shared_ptr<Texture> rotatingTexture    = std::make_shared<Texture>("asset/image/rotating.png");
-    static std::shared_ptr<Texture> backgroundTexture  = std::make_shared<Texture>("asset/image/background.png");
-    static std::shared_ptr<Texture> subTextureTest0    = std::make_shared<Texture>("asset/image/subtexturetest.png");
-    static std::shared_ptr<SubTexture> subTextureTest1 = std::make_shared<SubTexture>(subTextureTest0, 100, 100, 900, 900);
-    static std::shared_ptr<SubTexture> subTextureTest2 = std::make_shared<SubTexture>(subTextureTest1, 100, 100, 800, 800);
-    static std::shared_ptr<Font> robotoFont = std::make_shared<Font>(FontBuilder(), "asset/font/Roboto/Roboto-Regular.ttf", 34); 
+    Input &input = Input::Get();
+    PhysicsWorld &physics = PhysicsWorld::Get();
+    if(input.IsActionJustPressed(jumpAction))
+    {
+        physics.ApplyImpulse(body, b2Vec2(0.0f, 30.0f));
+        std::lock_guard<std::mutex> lock(pendingLogMutex);
+        LogLine line;
+        snprintf(line.text, sizeof(line.text), "Jump from x = %f", body->GetPosition().x);
+        pendingLog.push_back(line);
+    }
+    if(const int wheel = input.GetMouseWheelDirection())
+        logScroll.fetch_add(wheel, std::memory_order_relaxed);
 
-    auto& RenderSize = Renderer::Get().GetGameSize();
+    // Scaled by how long the keys were down during the tick, so short taps
+    // move the body a little rather than a whole tick's worth or not at all.
+    const float direction = input.GetActionHeldFraction(moveRightAction) - input.GetActionHeldFraction(moveLeftAction);
 
-    Renderer::Get().RenderBegin();
+    physics.ApplyForce(body, b2Vec2(direction * 50.0f, 0.0f));
+
+    // Applies what this tick and any other thread queued, steps, and
+    // publishes the bodies that moved.
+    physics.Step(step, tick_end);
+}
+
+void Game::Animate(const FrameGraph::FrameInfo &frame)
+{
+    SceneBuffer &scene = scenes[frame.Copy(2)].emplace(frame.memory);
+    const glm::vec2 &RenderSize = Renderer::Get().GetGameSize();
 
     static float theta = 0.0f;
-    theta = fmodf(theta + delta, glm::pi<float>() * 2.0f);
+    theta = fmodf(theta + frame.delta, glm::pi<float>() * 2.0f);
+
+    // Sized for last frame's sprites, so the list does not regrow through the arena.
+    static size_t sprite_count = 0;
+    ArenaVector<Sprite> &sprites = scene.sprites;
+    sprites.reserve(sprite_count);
+    auto add_texture = [&sprites](uint8_t layer, TextureHandle texture, const glm::vec2 &size, Transform2D transform) {
+        sprites.push_back(Sprite{ Sprite::Type::Texture, layer, texture, SubTextureHandle(), size / 2.0f, transform, glm::vec4(1.0f) });
+    };
+    auto add_sub_texture = [&sprites](uint8_t layer, SubTextureHandle texture, const glm::vec2 &size, Transform2D transform) {
+        sprites.push_back(Sprite{ Sprite::Type::SubTexture, layer, TextureHandle(), texture, size / 2.0f, transform, glm::vec4(1.0f) });
+    };
+    auto add_quad = [&sprites](uint8_t layer, Transform2D transform, const glm::vec4 &color) {
+        sprites.push_back(Sprite{ Sprite::Type::Quad, layer, TextureHandle(), SubTextureHandle(), glm::vec2(1.0f), transform, color });
+    };
 
     {
         const int size = 5;
@@ -65,57 +240,162 @@ void Game::Frame(float delta)
         {
             for(int y = 0; y < size; y++)
             {
-                Renderer::Get().RenderTexturedQuad(backgroundTexture, Transform2D(glm::vec2(RenderSize.x * (x + 0.5f) / (float)size, RenderSize.y * (y + 0.5f) / (float)size), glm::vec2(0.4f)));
+                add_texture(0, backgroundTexture, backgroundSize, Transform2D(glm::vec2(RenderSize.x * (x + 0.5f) / (float)size, RenderSize.y * (y + 0.5f) / (float)size), glm::vec2(0.4f)));
             }
         }
     }
-    
-    Renderer::Get().RenderTexturedQuad(subTextureTest0, Transform2D(glm::vec2(200.0f, 200.0f), glm::vec2(0.2f)));
-    Renderer::Get().RenderTexturedQuad(subTextureTest1, Transform2D(glm::vec2(400.0f, 200.0f), glm::vec2(0.2f)));
-    Renderer::Get().RenderTexturedQuad(subTextureTest2, Transform2D(glm::vec2(600.0f, 200.0f), glm::vec2(0.2f)));
 
-    Renderer::Get().RenderQuad(Transform2D(glm::vec2(RenderSize.x / 2 + 250, RenderSize.y / 2), glm::vec2(100.0f, 100.0f), glm::pi<float>() / 4.0f), glm::vec4(0.4f, 0.7f, 0.3f, 1.0f));
+    add_texture(1, subTextureTest0, subTextureTestSizes[0], Transform2D(glm::vec2(200.0f, 200.0f), glm::vec2(0.2f)));
+    add_sub_texture(2, subTextureTest1, subTextureTestSizes[1], Transform2D(glm::vec2(400.0f, 200.0f), glm::vec2(0.2f)));
+    add_sub_texture(3, subTextureTest2, subTextureTestSizes[2], Transform2D(glm::vec2(600.0f, 200.0f), glm::vec2(0.2f)));
+
+    add_quad(4, Transform2D(glm::vec2(RenderSize.x / 2 + 250, RenderSize.y / 2), glm::vec2(100.0f, 100.0f), glm::pi<float>() / 4.0f), glm::vec4(0.4f, 0.7f, 0.3f, 1.0f));
 
-    Renderer::Get().RenderTexturedQuad(rotatingTexture, Transform2D(glm::vec2(RenderSize.x / 2 + sinf(theta) * 150, RenderSize.y / 2), glm::vec2(0.4f), theta));
+    add_texture(5, rotatingTexture, rotatingSize, Transform2D(glm::vec2(RenderSize.x / 2 + sinf(theta) * 150, RenderSize.y / 2), glm::vec2(0.4f), theta));
 
     {
-        if(Input::Get().IsKeyJustPressed(SDLK_SPACE))
-            body->ApplyLinearImpulseToCenter(b2Vec2(0.0f, 30.0f), true);
-
-        float direction = 0.0f;
-
-        if(Input::Get().IsKeyPressed(SDLK_LEFT) || Input::Get().IsKeyPressed(SDLK_a))
-            direction -= 1.0f;
-        if(Input::Get().IsKeyPressed(SDLK_RIGHT) || Input::Get().IsKeyPressed(SDLK_d))
-            direction += 1.0f;  
-
-        body->ApplyForceToCenter(b2Vec2(direction * 50.0f, 0.0f), true); 
-        
-        float scale = 30.0f;
-
-        world->Step(delta, velocityIterations, positionIterations);
-        b2Vec2 bodyPos = body->GetPosition();
-        float bodyRotation = body->GetAngle();
-        b2Vec2 groundPos = groundBody->GetPosition();
-        float groundRotation = groundBody->GetAngle();
-        
-        Renderer::Get().RenderQuad(Transform2D(glm::vec2(scale * bodyPos.x   + RenderSize.x / 2.0f, RenderSize.y - scale * bodyPos.y   - 100), glm::vec2(1.0f) * scale         , bodyRotation), glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
-        Renderer::Get().RenderQuad(Transform2D(glm::vec2(scale * groundPos.x + RenderSize.x / 2.0f, RenderSize.y - scale * groundPos.y - 100), glm::vec2(50.0f, 10.0f) * scale, groundRotation));
+        // Every sprite is rebuilt each frame, so the dirty set is not needed here.
+        PhysicsWorld::Get().TakeTransforms(bodyTransforms);
+        std::fill(bodyTransforms.dirty.begin(), bodyTransforms.dirty.end(), 0);
+
+        // Blend by how far now is past the last tick. The next tick normally
+        // lands before alpha reaches 1; if the simulation falls behind the
+        // bodies stop at their last state rather than being extrapolated.
+        const float alpha = Simulation::Get().GetAlpha(bodyTransforms.tickEnd);
+        const float alpha_inverse = 1.0f - alpha;
+        const PhysicsWorld::Transforms &t = bodyTransforms;
+        const float scale = 30.0f;
+        auto add_body = [&](uint32_t slot, const glm::vec2 &size, const glm::vec4 &color) {
+            const float x = alpha_inverse * t.previousX[slot] + alpha * t.x[slot];
+            const float y = alpha_inverse * t.previousY[slot] + alpha * t.y[slot];
+            const float rotation = alpha_inverse * t.previousAngle[slot] + alpha * t.angle[slot];
+            add_quad(6, Transform2D(glm::vec2(scale * x + RenderSize.x / 2.0f, RenderSize.y - scale * y - 100), size * scale, rotation), color);
+        };
+        add_body(bodySlot, glm::vec2(1.0f), glm::vec4(1.0f, 0.5f, 0.0f, 1.0f));
+        add_body(groundSlot, glm::vec2(50.0f, 10.0f), glm::vec4(1.0f));
+    }
+    sprite_count = sprites.size();
+}
+
+void Game::Cull(const FrameGraph::FrameInfo &frame)
+{
+    SceneBuffer &scene = *scenes[frame.Copy(2)];
+    const glm::vec2 &RenderSize = Renderer::Get().GetGameSize();
+
+    scene.visible.reserve(scene.sprites.size());
+    for(uint32_t i = 0; i < scene.sprites.size(); i++)
+    {
+        const Sprite &sprite = scene.sprites[i];
+        // Bounds of the transformed quad, from its centre and the absolute
+        // values of its axes.
+        const glm::mat4 &m = sprite.transform;
+        const float half_x = fabsf(m[0].x) * sprite.extent.x + fabsf(m[1].x) * sprite.extent.y;
+        const float half_y = fabsf(m[0].y) * sprite.extent.x + fabsf(m[1].y) * sprite.extent.y;
+        if(m[3].x + half_x < 0.0f || m[3].y + half_y < 0.0f || m[3].x - half_x > RenderSize.x || m[3].y - half_y > RenderSize.y)
+            continue;
+        scene.visible.push_back(i);
+    }
+}
+
+void Game::Batch(const FrameGraph::FrameInfo &frame)
+{
+    SceneBuffer &scene = *scenes[frame.Copy(2)];
+    const ArenaVector<Sprite> &sprites = scene.sprites;
+    // Group by texture within each layer so texture slots fill up in runs.
+    std::stable_sort(scene.visible.begin(), scene.visible.end(), [&sprites](uint32_t a, uint32_t b) {
+        const Sprite &left = sprites[a], &right = sprites[b];
+        if(left.layer != right.layer) return left.layer < right.layer;
+        if(left.type != right.type) return left.type < right.type;
+        return (left.texture.GetValue() | left.subTexture.GetValue()) < (right.texture.GetValue() | right.subTexture.GetValue());
+    });
+}
+
+void Game::Submit(const FrameGraph::FrameInfo &frame)
+{
+    SceneBuffer &scene = *scenes[frame.Copy(2)];
+    auto& RenderSize = Renderer::Get().GetGameSize();
+
+    {
+        std::lock_guard<std::mutex> lock(pendingLogMutex);
+        if(!pendingLog.empty())
+        {
+            // The console keeps every paragraph, so adding and wrapping one
+            // allocates. That happens per event, not per frame.
+            AllocationTracker::Exemption exemption;
+            for(const LogLine &line : pendingLog)
+                eventLog.AddParagraph(line.text);
+            eventLog.Update();
+            pendingLog.clear();
+        }
+    }
+    eventLog.ScrollBy(-(float)logScroll.exchange(0, std::memory_order_relaxed) * eventLog.GetLineHeight() * 3.0f);
+
+    Renderer::Get().RenderBegin();
+
+    for(uint32_t index : scene.visible)
+    {
+        const Sprite &sprite = scene.sprites[index];
+        switch(sprite.type)
+        {
+        case Sprite::Type::Quad:
+            Renderer::Get().RenderQuad(sprite.transform, sprite.color);
+            break;
+        case Sprite::Type::Texture:
+            Renderer::Get().RenderTexturedQuad(sprite.texture, sprite.transform);
+            break;
+        case Sprite::Type::SubTexture:
+            Renderer::Get().RenderTexturedQuad(sprite.subTexture, sprite.transform);
+            break;
+        }
+    }
+
+    {
+        Renderer::TextEffects effects;
+        effects.outlineColor = glm::vec4(0.1f, 0.1f, 0.1f, 1.0f);
+        effects.outlineWidth = 2.0f;
+        effects.shadowColor = glm::vec4(0.0f, 0.0f, 0.0f, 0.5f);
+        effects.shadowOffset = glm::vec2(3.0f, 3.0f);
+        Renderer::Get().SetTextEffects(effects);
+        Renderer::Get().RenderText(glm::ivec2(20, 20), titleText, glm::vec4(1.0f, 0.8f, 0.2f, 1.0f));
+        Renderer::Get().RenderText(glm::ivec2(24, 90), subtitleText, glm::vec4(1.0f));
+        Renderer::Get().SetTextEffects(Renderer::TextEffects());
     }
 
     {
         const static unsigned int fps_history_count = 15;
         static int fps_pos = 0;
         static std::array<float, fps_history_count> fps_history = { 0.0f };
-        fps_history[fps_pos] = delta;
+        fps_history[fps_pos] = frame.delta;
         fps_pos = (fps_pos + 1) % fps_history_count;
         float fps = 0.0f;
         for(auto f : fps_history)
             fps += f;
         fps /= fps_history_count;
         fps = 1.0f / fps;
-        Renderer::Get().RenderText((glm::ivec2)RenderSize - glm::ivec2(170, 20), robotoFont, std::string("FPS: ").append(std::to_string((int)ceilf(fps))), glm::vec4(0.1f, 0.1f, 0.1f, 1.0f), Renderer::TextHAlign::Left, Renderer::TextVAlign::Bottom);
+        // Only rebuild the string and layout when the displayed number changes.
+        static int shown_fps = -1;
+        if((int)ceilf(fps) != shown_fps)
+        {
+            shown_fps = (int)ceilf(fps);
+            char digits[16];
+            snprintf(digits, sizeof(digits), "%d", shown_fps);
+            ArenaString label("FPS: ", frame.memory);
+            label += digits;
+            fpsText.SetText(label);
+        }
+        Renderer::Get().RenderText((glm::ivec2)RenderSize - glm::ivec2(170, 20), fpsText, glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
     }
 
+    {
+        Renderer::Get().RenderText(glm::ivec2(20, (int)RenderSize.y - 140), eventLog, glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+    }
+
+    // The arena is reset at RenderEnd, so the scene has to go first.
+    scenes[frame.Copy(2)].reset();
     Renderer::Get().RenderEnd();
+    Simulation::Get().OnFramePresented();
+
+    // The scene is always in motion; a menu or editor screen would only ask
+    // for the next frame while something on it animates.
+    FramePacer::Get().RequestRedraw();
 }
\ No newline at end of file
@@ -1,15 +1,32 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <SDL.h>
 #include <glm/vec2.hpp>
 
 #include "Singleton.hpp"
+#include "Core/FrameGraph.hpp"
 
 class Game {
     SINGLETON(Game);
 private:
     SDL_Window *m_pWindow = nullptr;
 public:
+    // Queues the game's assets for background loading; call before Init.
+    void Preload();
     void Init(SDL_Window *pWindow);
-    void Frame(float delta);
-};
\ No newline at end of file
+    // Adds the game's stages, which read the "Assets" resource the caller's
+    // stages write.
+    void BuildFrameGraph(FrameGraph &graph);
+private:
+    // Advances the simulation by one fixed step, on the simulation thread.
+    static void Tick(float step, Uint64 tick_end);
+    // Builds the frame's sprites, interpolating bodies between their last two ticks.
+    static void Animate(const FrameGraph::FrameInfo &frame);
+    static void Cull(const FrameGraph::FrameInfo &frame);
+    static void Batch(const FrameGraph::FrameInfo &frame);
+    // Draws the frame; the only stage that touches OpenGL.
+    static void Submit(const FrameGraph::FrameInfo &frame);
+};
@@ -1,32 +1,82 @@
 #include "Input.hpp"
 
 #include <string.h>
+#include <algorithm>
 
 void Input::Init()
 {
     m_MousePosition.fill(0);
     m_MouseMotion.fill(0);
     m_MouseWheelDirection = 0;
-    m_KeyState.fill(0);
+    m_KeysDown.fill(0);
+    m_KeysJustPressed.fill(0);
     m_MouseButtonState.fill(0);
+    m_ActionsDown = m_ActionsJustPressed = m_ActionsJustReleased = 0;
+    m_ActionPressTime.fill(0);
+    m_ActionHeldTime.fill(0);
 }
 
-void Input::Frame()
+void Input::BeginTick(Uint64 start, Uint64 end)
 {
-    m_MouseMotion.fill(0);
-    m_MouseWheelDirection = 0;
+    m_TickStart = start;
+    m_TickEnd = end;
+}
 
-    for(int i = 0; i < SDL_NUM_SCANCODES; i++)
-        m_KeyState[i] = m_KeyState[i] & ~BUTTONSTATEFLAG_JUST_PRESSED;
+void Input::Tick()
+{
+    m_KeysJustPressed.fill(0);
 
     for(int i = 0; i < 5; i++)
         m_MouseButtonState[i] = m_MouseButtonState[i] & ~BUTTONSTATEFLAG_JUST_PRESSED;
+
+    m_MouseMotion.fill(0);
+    m_MouseWheelDirection = 0;
+
+    // Only actions released during the tick have held time to reset.
+    Word released = m_ActionsJustReleased;
+    for(unsigned int i = 0; released; i++, released >>= 1)
+        if(released & 1)
+            m_ActionHeldTime[i] = 0;
+    m_ActionsJustPressed = m_ActionsJustReleased = 0;
 }
 
-void Input::HandleKeyboard(int key, bool state)
+void Input::HandleEvent(const InputEvent &event)
+{
+    switch(event.type)
+    {
+    case InputEvent::Type::Key:
+        HandleKeyboard(event.code, event.state, event.timestamp);
+        break;
+    case InputEvent::Type::MouseButton:
+        HandleMouseButton(event.code, event.state);
+        break;
+    case InputEvent::Type::MouseMotion:
+        HandleMouseMovement(event.x, event.y, event.relx, event.rely);
+        break;
+    case InputEvent::Type::MouseWheel:
+        HandleMouseWheel(event.code);
+        break;
+    }
+}
+
+void Input::HandleKeyboard(int key, bool state, Uint64 timestamp)
 {
     if(key < 0 || key >= SDL_NUM_SCANCODES) return;
-    m_KeyState[key] = state * (BUTTONSTATEFLAG_PRESSED | BUTTONSTATEFLAG_JUST_PRESSED);
+    const Word bit = Word(1) << (key % 64);
+    Word &down = m_KeysDown[key / 64];
+    if(state == ((down & bit) != 0)) return;
+    if(state)
+    {
+        down |= bit;
+        m_KeysJustPressed[key / 64] |= bit;
+    }
+    else
+        down &= ~bit;
+
+    Word actions = m_KeyActions[key];
+    for(Action action = 0; actions; action++, actions >>= 1)
+        if(actions & 1)
+            UpdateAction(action, timestamp);
 }
 
 void Input::HandleMouseMovement(int x, int y, int relx, int rely)
@@ -48,18 +98,107 @@ void Input::HandleMouseWheel(int direction)
     m_MouseWheelDirection += direction;
 }
 
+Input::Action Input::AddAction(const std::string &name, std::initializer_list<SDL_Scancode> keys)
+{
+    Action action = FindAction(name);
+    if(action == INVALID_ACTION)
+    {
+        if(m_ActionNames.size() >= MAX_ACTIONS)
+        {
+            SDL_Log("Too many input actions, can't add \"%s\"\n", name.c_str());
+            return INVALID_ACTION;
+        }
+        action = (Action)m_ActionNames.size();
+        m_ActionNames.push_back(name);
+        m_ActionBindings.emplace_back();
+        m_ActionBindings.back().fill(0);
+    }
+    for(SDL_Scancode key : keys)
+        Bind(action, key);
+    return action;
+}
+
+Input::Action Input::FindAction(const std::string &name) const
+{
+    for(size_t i = 0; i < m_ActionNames.size(); i++)
+        if(m_ActionNames[i] == name)
+            return (Action)i;
+    return INVALID_ACTION;
+}
+
+void Input::Bind(Action action, SDL_Scancode key)
+{
+    if(action >= m_ActionNames.size() || key < 0 || key >= SDL_NUM_SCANCODES) return;
+    m_ActionBindings[action][key / 64] |= Word(1) << (key % 64);
+    m_KeyActions[key] |= Word(1) << action;
+    // A key that is already down presses the action from the start of the tick.
+    UpdateAction(action, m_TickStart);
+}
+
+void Input::Unbind(Action action, SDL_Scancode key)
+{
+    if(action >= m_ActionNames.size() || key < 0 || key >= SDL_NUM_SCANCODES) return;
+    m_ActionBindings[action][key / 64] &= ~(Word(1) << (key % 64));
+    m_KeyActions[key] &= ~(Word(1) << action);
+    UpdateAction(action, m_TickStart);
+}
+
+void Input::ClearBindings(Action action)
+{
+    if(action >= m_ActionNames.size()) return;
+    m_ActionBindings[action].fill(0);
+    for(Word &actions : m_KeyActions)
+        actions &= ~(Word(1) << action);
+    UpdateAction(action, m_TickStart);
+}
+
+void Input::UpdateAction(Action action, Uint64 timestamp)
+{
+    const KeySet &bindings = m_ActionBindings[action];
+    Word any = 0;
+    for(unsigned int i = 0; i < KEY_WORDS; i++)
+        any |= bindings[i] & m_KeysDown[i];
+
+    const Word bit = Word(1) << action;
+    const bool down = any != 0;
+    if(down == ((m_ActionsDown & bit) != 0)) return;
+    if(down)
+    {
+        m_ActionsDown |= bit;
+        m_ActionsJustPressed |= bit;
+        m_ActionPressTime[action] = timestamp;
+        return;
+    }
+    m_ActionsDown &= ~bit;
+    m_ActionsJustReleased |= bit;
+    if(timestamp > m_TickStart)
+        m_ActionHeldTime[action] += timestamp - std::max(m_ActionPressTime[action], m_TickStart);
+}
+
+float Input::GetActionHeldFraction(Action action) const
+{
+    if(action >= MAX_ACTIONS) return 0.0f;
+    const bool down = (m_ActionsDown >> action) & 1;
+    if(m_TickEnd <= m_TickStart) return down ? 1.0f : 0.0f;
+
+    Uint64 held = m_ActionHeldTime[action];
+    if(down)
+        held += m_TickEnd - std::min(m_TickEnd, std::max(m_ActionPressTime[action], m_TickStart));
+    return std::min(1.0f, (float)held / (float)(m_TickEnd - m_TickStart));
+}
+
 bool Input::IsKeyJustPressed(int key)
 {
     key = SDL_GetScancodeFromKey(key);
     if(key < 0 || key >= SDL_NUM_SCANCODES) return false;
-    return m_KeyState[key] & BUTTONSTATEFLAG_JUST_PRESSED;
+    return (m_KeysJustPressed[key / 64] >> (key % 64)) & 1;
 }
 
 bool Input::IsKeyPressed(int key)
 {
     key = SDL_GetScancodeFromKey(key);
     if(key < 0 || key >= SDL_NUM_SCANCODES) return false;
-    return m_KeyState[key] & BUTTONSTATEFLAG_PRESSED;
+    return (m_KeysDown[key / 64] >> (key % 64)) & 1;
 }
 
 bool Input::IsMouseButtonJustPressed(int button)
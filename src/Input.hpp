@@ -1,36 +1,104 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
 
 #include <glm/vec2.hpp>
 #include <SDL.h>
 
 #include "Singleton.hpp"
 
+// One input event as the main thread hands it to the simulation.
+struct InputEvent
+{
+    enum class Type : uint8_t { Key, MouseButton, MouseMotion, MouseWheel };
+    Type type;
+    bool state;
+    // Scancode, mouse button or wheel direction.
+    int code;
+    int x, y, relx, rely;
+    // SDL_GetPerformanceCounter when the event was polled.
+    Uint64 timestamp;
+};
+
 class Input
 {
     SINGLETON(Input);
+public:
+    // Index of a named action, bound to any number of keys. Game code asks
+    // about actions rather than keys, so players can rebind them.
+    typedef uint8_t Action;
+    static constexpr unsigned int MAX_ACTIONS = 64;
+    static constexpr Action INVALID_ACTION = 0xFF;
 private:
     typedef unsigned char ButtonState;
     enum ButtonStateFlags {
         BUTTONSTATEFLAG_PRESSED = 1 << 0,
         BUTTONSTATEFLAG_JUST_PRESSED = 1 << 1,
     };
+    // One bit per scancode, or per action.
+    typedef uint64_t Word;
+    static constexpr unsigned int KEY_WORDS = (SDL_NUM_SCANCODES + 63) / 64;
+    typedef std::array<Word, KEY_WORDS> KeySet;
 private:
     std::array<int, 2> m_MouseMotion;
     std::array<int, 2> m_MousePosition;
     int m_MouseWheelDirection;
-    std::array<ButtonState, SDL_NUM_SCANCODES> m_KeyState;
+    // Keys that are down, and keys that went down since the last tick.
+    KeySet m_KeysDown;
+    KeySet m_KeysJustPressed;
     std::array<ButtonState, 5> m_MouseButtonState;
+
+    std::vector<std::string> m_ActionNames;
+    std::vector<KeySet> m_ActionBindings;
+    // The actions each key is bound to.
+    std::array<Word, SDL_NUM_SCANCODES> m_KeyActions = {};
+    // An action is down while any of its keys is. The edges are latched
+    // until the next tick, so a tap within one tick is both.
+    Word m_ActionsDown;
+    Word m_ActionsJustPressed;
+    Word m_ActionsJustReleased;
+    // When each action went down, and how long actions released during the
+    // current tick were held in it, in performance counter units.
+    std::array<Uint64, MAX_ACTIONS> m_ActionPressTime;
+    std::array<Uint64, MAX_ACTIONS> m_ActionHeldTime;
+    Uint64 m_TickStart = 0, m_TickEnd = 0;
 public:
+    // Resets input state; actions and their bindings are kept.
     void Init();
-    void Frame();
+    // Call before applying a tick's events, with the span of time the tick covers.
+    void BeginTick(Uint64 start, Uint64 end);
+    // Call after every simulation tick. Just-pressed flags, mouse motion and
+    // the wheel last until then, so a press is seen by exactly one tick even
+    // when it is released within that tick.
+    void Tick();
 
-    void HandleKeyboard(int key, bool state);
+    void HandleEvent(const InputEvent &event);
+    void HandleKeyboard(int key, bool state, Uint64 timestamp = 0);
     void HandleMouseMovement(int x, int y, int relx, int rely);
     void HandleMouseButton(int button, bool state);
     void HandleMouseWheel(int direction);
 
+    // Actions are added and rebound before the simulation starts or from a
+    // tick, on the thread that applies input. Adding an existing name
+    // returns that action; INVALID_ACTION means all MAX_ACTIONS are taken.
+    Action AddAction(const std::string &name, std::initializer_list<SDL_Scancode> keys = {});
+    Action FindAction(const std::string &name) const;
+    void Bind(Action action, SDL_Scancode key);
+    void Unbind(Action action, SDL_Scancode key);
+    void ClearBindings(Action action);
+
+    inline bool IsActionPressed(Action action) const { return action < MAX_ACTIONS && (m_ActionsDown >> action) & 1; }
+    inline bool IsActionJustPressed(Action action) const { return action < MAX_ACTIONS && (m_ActionsJustPressed >> action) & 1; }
+    inline bool IsActionJustReleased(Action action) const { return action < MAX_ACTIONS && (m_ActionsJustReleased >> action) & 1; }
+    // How much of the current tick the action was down for, from 0 to 1, so
+    // a tap shorter than a tick still has a proportional effect.
+    float GetActionHeldFraction(Action action) const;
+
+    // Keys by keycode, for debugging shortcuts; game controls should be actions.
     bool IsKeyJustPressed(int key);
     bool IsKeyPressed(int key);
     bool IsMouseButtonJustPressed(int button);
@@ -38,5 +106,7 @@ public:
     glm::vec2 GetMousePosition();
     glm::vec2 GetMouseMovement();
     int GetMouseWheelDirection();
-    
+private:
+    // Brings the action in line with its keys after a key or binding changed.
+    void UpdateAction(Action action, Uint64 timestamp);
 };
@@ -0,0 +1,170 @@
+#include "PhysicsWorld.hpp"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit of a non-zero word.
+static inline unsigned int LowestBit(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(word);
+#endif
+}
+
+static constexpr size_t DirtyWords(size_t count)
+{
+    return (count + 63) / 64;
+}
+
+void PhysicsWorld::Transforms::Resize(size_t count)
+{
+    x.resize(count);
+    y.resize(count);
+    angle.resize(count);
+    previousX.resize(count);
+    previousY.resize(count);
+    previousAngle.resize(count);
+    dirty.resize(DirtyWords(count));
+}
+
+void PhysicsWorld::Transforms::CopySlot(const Transforms &from, uint32_t slot)
+{
+    x[slot] = from.x[slot];
+    y[slot] = from.y[slot];
+    angle[slot] = from.angle[slot];
+    previousX[slot] = from.previousX[slot];
+    previousY[slot] = from.previousY[slot];
+    previousAngle[slot] = from.previousAngle[slot];
+}
+
+void PhysicsWorld::Init(const b2Vec2 &gravity)
+{
+    m_World = std::make_unique<b2World>(gravity);
+    m_Queued.clear();
+    m_Applying.clear();
+    m_Synced = Transforms();
+    m_LastMoved.clear();
+    std::lock_guard<std::mutex> lock(m_PublishedMutex);
+    m_Published = Transforms();
+}
+
+uint32_t PhysicsWorld::AddBody(b2Body *body)
+{
+    const uint32_t slot = (uint32_t)m_Synced.GetCount();
+    // Zero marks a body without a slot.
+    body->GetUserData().pointer = (uintptr_t)slot + 1;
+
+    m_Synced.Resize(slot + 1);
+    m_Synced.x[slot] = m_Synced.previousX[slot] = body->GetPosition().x;
+    m_Synced.y[slot] = m_Synced.previousY[slot] = body->GetPosition().y;
+    m_Synced.angle[slot] = m_Synced.previousAngle[slot] = body->GetAngle();
+    m_LastMoved.resize(m_Synced.dirty.size());
+
+    std::lock_guard<std::mutex> lock(m_PublishedMutex);
+    m_Published.Resize(slot + 1);
+    m_Published.CopySlot(m_Synced, slot);
+    m_Published.dirty[slot / 64] |= uint64_t(1) << (slot % 64);
+    return slot;
+}
+
+void PhysicsWorld::Queue(const Command &command)
+{
+    std::lock_guard<std::mutex> lock(m_QueueMutex);
+    m_Queued.push_back(command);
+}
+
+void PhysicsWorld::Step(float step, uint64_t tick_end)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        m_Queued.swap(m_Applying);
+    }
+    for(const Command &command : m_Applying)
+    {
+        switch(command.type)
+        {
+        case Command::Type::Force:
+            command.body->ApplyForceToCenter(command.vector, true);
+            break;
+        case Command::Type::Impulse:
+            command.body->ApplyLinearImpulseToCenter(command.vector, true);
+            break;
+        }
+    }
+    m_Applying.clear();
+
+    m_World->Step(step, m_VelocityIterations, m_PositionIterations);
+    SyncTransforms(tick_end);
+}
+
+void PhysicsWorld::SyncTransforms(uint64_t tick_end)
+{
+    Transforms &synced = m_Synced;
+    std::vector<uint64_t> &moved = synced.dirty;
+    std::fill(moved.begin(), moved.end(), 0);
+
+    // Sleeping and static bodies keep the transform they had.
+    for(b2Body *body = m_World->GetBodyList(); body; body = body->GetNext())
+    {
+        const uintptr_t slot_plus_one = body->GetUserData().pointer;
+        if(!slot_plus_one || !body->IsAwake() || body->GetType() == b2_staticBody) continue;
+        const uint32_t slot = (uint32_t)(slot_plus_one - 1);
+        const b2Vec2 &position = body->GetPosition();
+        const float angle = body->GetAngle();
+        if(position.x == synced.x[slot] && position.y == synced.y[slot] && angle == synced.angle[slot]) continue;
+
+        synced.previousX[slot] = synced.x[slot];
+        synced.previousY[slot] = synced.y[slot];
+        synced.previousAngle[slot] = synced.angle[slot];
+        synced.x[slot] = position.x;
+        synced.y[slot] = position.y;
+        synced.angle[slot] = angle;
+        moved[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    std::lock_guard<std::mutex> lock(m_PublishedMutex);
+    m_Published.tickEnd = tick_end;
+    for(size_t word = 0; word < moved.size(); word++)
+    {
+        // A body that stopped this step still has last step's movement to
+        // interpolate away, so it is caught up and published once more.
+        const uint64_t stopped = m_LastMoved[word] & ~moved[word];
+        uint64_t changed = moved[word] | stopped;
+        m_LastMoved[word] = moved[word];
+        m_Published.dirty[word] |= changed;
+        for(; changed; changed &= changed - 1)
+        {
+            const uint32_t slot = (uint32_t)(word * 64 + LowestBit(changed));
+            if((stopped >> (slot % 64)) & 1)
+            {
+                synced.previousX[slot] = synced.x[slot];
+                synced.previousY[slot] = synced.y[slot];
+                synced.previousAngle[slot] = synced.angle[slot];
+            }
+            m_Published.CopySlot(synced, slot);
+        }
+    }
+}
+
+void PhysicsWorld::TakeTransforms(Transforms &transforms)
+{
+    std::lock_guard<std::mutex> lock(m_PublishedMutex);
+    if(transforms.GetCount() != m_Published.GetCount())
+        transforms.Resize(m_Published.GetCount());
+    transforms.tickEnd = m_Published.tickEnd;
+    for(size_t word = 0; word < m_Published.dirty.size(); word++)
+    {
+        uint64_t changed = m_Published.dirty[word];
+        transforms.dirty[word] |= changed;
+        m_Published.dirty[word] = 0;
+        for(; changed; changed &= changed - 1)
+            transforms.CopySlot(m_Published, (uint32_t)(word * 64 + LowestBit(changed)));
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+#include "../Singleton.hpp"
+
+// Owns the box2d world, which only the simulation's ticks step. Code on
+// any other thread that wants to push a body around queues a command
+// instead; the next step applies it before integrating, so the world is
+// never touched while it steps.
+//
+// Bodies added with AddBody get a transform slot. After every step one
+// pass over the body list copies the transforms of awake bodies that
+// moved into flat arrays, and readers take just the slots that changed.
+class PhysicsWorld
+{
+    SINGLETON(PhysicsWorld);
+public:
+    struct Command
+    {
+        enum class Type : uint8_t { Force, Impulse };
+        Type type;
+        b2Body *body;
+        b2Vec2 vector;
+    };
+    // Each body's transform after the last two steps, one array per
+    // component, indexed by slot.
+    struct Transforms
+    {
+        std::vector<float> x, y, angle;
+        std::vector<float> previousX, previousY, previousAngle;
+        // One bit per slot, set where the entry changed.
+        std::vector<uint64_t> dirty;
+        // The simulation time the newest step ended at.
+        uint64_t tickEnd = 0;
+
+        inline size_t GetCount() const { return x.size(); }
+        void Resize(size_t count);
+        void CopySlot(const Transforms &from, uint32_t slot);
+    };
+private:
+    std::unique_ptr<b2World> m_World;
+    int32 m_VelocityIterations = 8;
+    int32 m_PositionIterations = 3;
+    // Producers append to one list while the step applies the other, and
+    // both keep their capacity, so queuing does not allocate once warm.
+    std::vector<Command> m_Queued;
+    std::vector<Command> m_Applying;
+    std::mutex m_QueueMutex;
+
+    // Simulation thread only. Slots that moved in the last step and the one before it.
+    Transforms m_Synced;
+    std::vector<uint64_t> m_LastMoved;
+    // What readers take from, with the slots changed since they last did.
+    Transforms m_Published;
+    std::mutex m_PublishedMutex;
+public:
+    void Init(const b2Vec2 &gravity);
+    // Direct access, for building the scene before the simulation starts
+    // and for reading bodies inside a tick.
+    b2World &GetWorld() { return *m_World; }
+
+    // Gives the body a transform slot, and returns it. Call where the world
+    // may be touched directly. Slots are not reused.
+    uint32_t AddBody(b2Body *body);
+
+    // Any thread. Applied by the next step, in the order queued.
+    void Queue(const Command &command);
+    void ApplyForce(b2Body *body, const b2Vec2 &force) { Queue(Command{ Command::Type::Force, body, force }); }
+    void ApplyImpulse(b2Body *body, const b2Vec2 &impulse) { Queue(Command{ Command::Type::Impulse, body, impulse }); }
+
+    // Simulation thread. Applies the queued commands, advances the world,
+    // and publishes the transforms of the bodies that moved. tick_end is
+    // the time the step simulates up to.
+    void Step(float step, uint64_t tick_end);
+
+    // Any thread, but one reader only. Copies the slots that changed since
+    // the last call into transforms, which should be kept between calls,
+    // and sets their bits in its dirty set.
+    void TakeTransforms(Transforms &transforms);
+private:
+    void SyncTransforms(uint64_t tick_end);
+};
@@ -1,144 +1,554 @@
 #include "Font.hpp"
 
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <algorithm>
+
 #include <freetype/freetype.h>
+#include <freetype/ftmodapi.h>
+#include <freetype/tttables.h>
+#include <freetype/tttags.h>
 #include <SDL_log.h>
 #include <glad/glad.h>
 
-Font::Font(const FontBuilder &fontBuilder, const std::string& font_path, int font_size)
-    : m_Characters(std::unique_ptr<FontCharacter[]>(new FontCharacter[128])), m_FontSize(font_size)
+#include "Utf8.hpp"
+#include "../Core/JobSystem.hpp"
+#include "../Resource/Hash.hpp"
+
+// Empty texels kept right of and below every glyph so linear filtering never
+// samples a neighbour.
+static const unsigned int GLYPH_PADDING = 1;
+// Opening a FreeType instance costs about as much as rendering a handful of
+// glyphs, so each rasterization task takes at least this many.
+static const unsigned int GLYPHS_PER_TASK = 16;
+
+unsigned int Font::s_Frame = 0;
+
+static unsigned int PageSizeFor(int font_size)
 {
-    const unsigned int texture_rows = 11;
-    const unsigned int texture_size = texture_rows * font_size;
+    unsigned int size = 256;
+    while(size < (unsigned int)font_size * 16 && size < 2048)
+        size *= 2;
+    return size;
+}
 
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGBA,
-        texture_size,
-        texture_size,
-        0,
-        GL_RGBA,
-        GL_UNSIGNED_BYTE,
-        nullptr
-    );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+// Both SDF rasterizers default to a spread of 2, too narrow for outlines.
+static void SetDistanceFieldSpread(FT_Library library)
+{
+    FT_Int spread = Font::DISTANCE_FIELD_SPREAD;
+    FT_Property_Set(library, "sdf", "spread", &spread);
+    FT_Property_Set(library, "bsdf", "spread", &spread);
+}
 
-    m_Texture = std::make_shared<FontTexture>(texture, texture_size);
+// Opens a private FreeType instance for one thread.
+static bool OpenFace(const unsigned char *font_data, long font_data_size, int font_size, FT_Library &library, FT_Face &face, const std::string &debug_name)
+{
+    if(FT_Init_FreeType(&library))
+    {
+        SDL_Log("Cannot Init FreeType!\n");
+        return false;
+    }
+    SetDistanceFieldSpread(library);
 
-    FT_Face face;
-    if(FT_New_Face((FT_Library)fontBuilder.s_FreetypeLibrary, font_path.c_str(), 0, &face) )
+    if(FT_New_Memory_Face(library, font_data, font_data_size, 0, &face) )
+    {
+        SDL_Log("FAILED TO CREATE FONT %s.\n", debug_name.c_str());
+        FT_Done_FreeType(library);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, font_size);
+    return true;
+}
+
+static void CloseFace(FT_Library library, FT_Face face)
+{
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+}
+
+// Renders one glyph to single-channel pixels and fills in everything but its atlas placement.
+static bool RenderGlyph(FT_Face face, uint32_t codepoint, Font::Rendering rendering, Font::FontCharacter &character, std::vector<unsigned char> &pixels)
+{
+    character = Font::FontCharacter{};
+    if(rendering == Font::Rendering::DistanceField)
+    {
+        if(FT_Load_Char(face, codepoint, FT_LOAD_NO_HINTING) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
+            return false;
+    }
+    else if(FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+        return false;
+
+    const FT_Bitmap &bitmap = face->glyph->bitmap;
+    character.size = glm::u16vec2(bitmap.width, bitmap.rows);
+    character.bearing = glm::i16vec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+    character.advance = (int16_t)(face->glyph->advance.x >> 6);
+
+    pixels.resize((size_t)bitmap.width * bitmap.rows);
+    for(unsigned int y = 0; y < bitmap.rows; y++)
+        memcpy(&pixels[(size_t)y * bitmap.width], bitmap.buffer + (ptrdiff_t)y * bitmap.pitch, bitmap.width);
+    return true;
+}
+
+// Only fonts without a legacy kern table need their GPOS kerning read.
+static std::unique_ptr<GposKerning> LoadGposKerning(FT_Face face)
+{
+    FT_ULong length = 0;
+    if(FT_HAS_KERNING(face) || FT_Load_Sfnt_Table(face, TTAG_GPOS, 0, nullptr, &length) || !length)
+        return nullptr;
+    std::vector<unsigned char> table(length);
+    if(FT_Load_Sfnt_Table(face, TTAG_GPOS, 0, table.data(), &length))
+        return nullptr;
+    auto gpos = std::make_unique<GposKerning>();
+    if(!gpos->Load(table.data(), table.size()))
+        return nullptr;
+    return gpos;
+}
+
+// Kerning in 1/64 pixel, unhinted so distance-field fonts scale it cleanly.
+static int16_t KerningFor(FT_Face face, const GposKerning *gpos, uint32_t left, uint32_t right)
+{
+    const FT_UInt left_glyph = FT_Get_Char_Index(face, left);
+    const FT_UInt right_glyph = FT_Get_Char_Index(face, right);
+    if(!left_glyph || !right_glyph)
+        return 0;
+
+    FT_Pos adjustment = 0;
+    if(FT_HAS_KERNING(face))
+    {
+        FT_Vector kerning;
+        if(!FT_Get_Kerning(face, left_glyph, right_glyph, FT_KERNING_UNFITTED, &kerning))
+            adjustment = kerning.x;
+    }
+    else if(gpos)
+        adjustment = FT_MulFix(gpos->GetAdjustment((uint16_t)left_glyph, (uint16_t)right_glyph), face->size->metrics.x_scale);
+    return (int16_t)std::max<FT_Pos>(INT16_MIN, std::min<FT_Pos>(INT16_MAX, adjustment));
+}
+
+// Places a glyph on the shortest shelf it fits, opening a new shelf below the last one if needed.
+static bool PackGlyph(std::vector<Font::Shelf> &shelves, unsigned int page_size, const glm::ivec2 &size, glm::ivec2 &origin)
+{
+    const unsigned int width = size.x + GLYPH_PADDING;
+    const unsigned int height = size.y + GLYPH_PADDING;
+    if(width > page_size || height > page_size)
+        return false;
+
+    Font::Shelf *best = nullptr;
+    for(Font::Shelf &shelf : shelves)
+    {
+        if(shelf.height >= height && shelf.x + width <= page_size && (!best || shelf.height < best->height))
+            best = &shelf;
+    }
+    if(!best)
+    {
+        const unsigned int y = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+        if(y + height > page_size)
+            return false;
+        shelves.push_back(Font::Shelf{ y, height, 0 });
+        best = &shelves.back();
+    }
+
+    origin = glm::ivec2(best->x, best->y);
+    best->x += width;
+    return true;
+}
+
+Font::Font(const FontBuilder &fontBuilder, const std::string& font_path, int font_size)
+    : m_FontSize(font_size)
+{
+    std::ifstream stream(font_path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if(data.empty())
     {
         SDL_Log("FAILED TO CREATE FONT %s.\n", font_path.c_str());
+        return;
     }
 
-    FT_Set_Pixel_Sizes(face, 0, font_size);
+    FontAtlas atlas;
+    if(Rasterize(data.data(), (long)data.size(), font_size, atlas, font_path))
+        Adopt(std::move(atlas), font_path);
+}
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+Font::Font(const FontBuilder &fontBuilder, const unsigned char *font_data, long font_data_size, int font_size, const std::string &debug_name)
+    : m_FontSize(font_size)
+{
+    FontAtlas atlas;
+    if(Rasterize(font_data, font_data_size, font_size, atlas, debug_name))
+        Adopt(std::move(atlas), debug_name);
+}
 
-    for (unsigned char c = 0; c < 128; c++)
+Font::Font(FontAtlas &&atlas, const std::string &debug_name)
+    : m_FontSize(atlas.fontSize)
+{
+    Adopt(std::move(atlas), debug_name);
+}
+
+bool Font::Rasterize(const unsigned char *font_data, long font_data_size, int font_size, FontAtlas &atlas, const std::string &debug_name, Rendering rendering)
+{
+    // Opening the face here first means a broken file is reported once.
+    FT_Library library;
+    FT_Face face;
+    if(!OpenFace(font_data, font_data_size, font_size, library, face, debug_name))
+        return false;
+
+    // Printable ASCII is almost always needed, so it goes in up front.
+    // Everything else is rasterized the first time it is drawn.
+    const uint32_t first = 32, last = 127;
+    struct RenderedGlyph
     {
-        if(FT_Load_Char(face, c, FT_LOAD_RENDER))
-        {
-            SDL_Log("Typetype failed to load char\n");
-            continue;
-        }
+        FontCharacter character;
+        std::vector<unsigned char> pixels;
+        bool rendered = false;
+    };
+    std::vector<RenderedGlyph> glyphs(last - first);
 
-        struct Pixel {
-            unsigned char r, g, b, a;
-        };
+    // Each task renders every chunk_count-th glyph with its own FreeType
+    // instance, which spreads wide and narrow glyphs evenly.
+    JobSystem &jobs = JobSystem::Get();
+    const unsigned int chunk_count = std::max(1u, std::min(jobs.GetThreadCount() + 1, (unsigned int)glyphs.size() / GLYPHS_PER_TASK));
+    auto render = [&](FT_Face chunk_face, unsigned int chunk) {
+        for(size_t i = chunk; i < glyphs.size(); i += chunk_count)
+            glyphs[i].rendered = RenderGlyph(chunk_face, first + (uint32_t)i, rendering, glyphs[i].character, glyphs[i].pixels);
+    };
 
-        auto pixels = std::unique_ptr<Pixel[]>(new Pixel[face->glyph->bitmap.width * face->glyph->bitmap.rows]);
+    JobCounter tasks;
+    for(unsigned int chunk = 1; chunk < chunk_count; chunk++)
+    {
+        jobs.Submit([&, chunk]() {
+            FT_Library chunk_library;
+            FT_Face chunk_face;
+            if(!OpenFace(font_data, font_data_size, font_size, chunk_library, chunk_face, debug_name))
+                return;
+            render(chunk_face, chunk);
+            CloseFace(chunk_library, chunk_face);
+        }, &tasks, "Rasterize glyphs");
+    }
+    render(face, 0);
 
-        for(int i = 0; i < face->glyph->bitmap.width * face->glyph->bitmap.rows; i++)
+    // Kerning between printable ASCII pairs is read while the other tasks render.
+    std::unique_ptr<GposKerning> gpos = LoadGposKerning(face);
+    atlas.kerning = FT_HAS_KERNING(face) || gpos;
+    atlas.kerningPairs.clear();
+    if(atlas.kerning)
+    {
+        for(uint32_t left = first; left < last; left++)
         {
-            Pixel &pixel = pixels[i];
-            if(face->glyph->bitmap.buffer[i])
+            for(uint32_t right = first; right < last; right++)
             {
-                pixel.r = pixel.g = pixel.b = 255;
-                pixel.a = face->glyph->bitmap.buffer[i];
-            } else
-            {
-                pixel.r = pixel.g = pixel.b = pixel.a = 0;
+                const int16_t adjustment = KerningFor(face, gpos.get(), left, right);
+                if(adjustment)
+                    atlas.kerningPairs.push_back(KerningPair{ left, right, adjustment });
             }
         }
+    }
+
+    jobs.Wait(tasks);
+    atlas.lineHeight = (unsigned int)(face->size->metrics.height >> 6);
+    CloseFace(library, face);
 
-        glTexSubImage2D(
-            GL_TEXTURE_2D,
-            0,
-            (c % texture_rows) * font_size,
-            (c / texture_rows) * font_size,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE,
-            pixels.get()
-        );
-
-        m_Characters[c] = FontCharacter {
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x,
-            glm::vec2((float)((c % texture_rows) * font_size) / texture_size, (float)((c / texture_rows) * font_size) / texture_size),
-            glm::vec2((float)((c % texture_rows) * font_size + face->glyph->bitmap.width) / texture_size, (float)((c / texture_rows) * font_size + face->glyph->bitmap.rows) / texture_size)
-        };
+    atlas.fontSize = font_size;
+    atlas.rendering = rendering;
+    atlas.pageSize = PageSizeFor(font_size);
+    atlas.fontData.assign(font_data, font_data + font_data_size);
+    atlas.pixels.assign((size_t)atlas.pageSize * atlas.pageSize, 0);
+    atlas.shelves.clear();
+    atlas.characters.clear();
+    atlas.cacheFile.reset();
+    atlas.cachePixels = nullptr;
+
+    // Pack in codepoint order so the atlas is identical however the work was split.
+    for(size_t i = 0; i < glyphs.size(); i++)
+    {
+        FontCharacter &character = glyphs[i].character;
+        if(!glyphs[i].rendered)
+            SDL_Log("Typetype failed to load char\n");
+
+        if(character.size.x && character.size.y)
+        {
+            glm::ivec2 origin;
+            if(!PackGlyph(atlas.shelves, atlas.pageSize, glm::ivec2(character.size), origin))
+                continue;
+            const std::vector<unsigned char> &pixels = glyphs[i].pixels;
+            for(int y = 0; y < character.size.y; y++)
+                memcpy(&atlas.pixels[(size_t)(origin.y + y) * atlas.pageSize + origin.x], &pixels[(size_t)y * character.size.x], character.size.x);
+            character.position = glm::u16vec2(origin);
+        }
+        atlas.characters.emplace_back(first + (uint32_t)i, character);
     }
+    return true;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+uint32_t Font::GetRasterizerVersion()
+{
+    return FREETYPE_MAJOR * 10000 + FREETYPE_MINOR * 100 + FREETYPE_PATCH;
 }
 
-const Font::FontCharacter &Font::GetCharacter(unsigned char c) const
+bool Font::Open()
 {
-    return m_Characters[c];
+    FT_Library library;
+    FT_Face face;
+    if(!OpenFace(m_FontData.data(), (long)m_FontData.size(), m_FontSize, library, face, m_Name))
+    {
+        // Do not try again for every missing glyph.
+        m_FontData.clear();
+        return false;
+    }
+    m_Library = library;
+    m_Face = face;
+    if(m_HasKerning)
+        m_Gpos = LoadGposKerning(face);
+    return true;
 }
 
-Font::~Font()
+void Font::Adopt(FontAtlas &&atlas, const std::string &debug_name)
 {
+    if(m_Face) CloseFace((FT_Library)m_Library, (FT_Face)m_Face);
+    m_Library = m_Face = nullptr;
+
+    m_FontSize = atlas.fontSize;
+    m_Rendering = atlas.rendering;
+    m_PageSize = atlas.pageSize;
+    m_FontData = std::move(atlas.fontData);
+    m_Name = debug_name;
+    m_LineHeight = atlas.lineHeight ? atlas.lineHeight : m_FontSize;
+    m_Generation++;
+    m_Characters.clear();
+    m_Pages.clear();
+    m_Gpos.reset();
+    m_HasKerning = atlas.kerning;
+    m_Kerning.Clear();
+    for(const KerningPair &pair : atlas.kerningPairs)
+        m_Kerning.Insert(pair.left, pair.right, pair.adjustment);
+    m_Shapes.clear();
 
+    AddPage(atlas.GetPixels());
+    Page &page = m_Pages.front();
+    page.shelves = std::move(atlas.shelves);
+    for(const auto &entry : atlas.characters)
+    {
+        m_Characters[entry.first] = entry.second;
+        if(entry.second.size.x && entry.second.size.y)
+            page.codepoints.push_back(entry.first);
+    }
 }
 
-Font::FontTexture::FontTexture(unsigned int textureID, unsigned int size)
-    : Texture(textureID, glm::ivec2(size), 4)
+const Font::FontCharacter &Font::GetCharacter(uint32_t codepoint)
 {
+    auto found = m_Characters.find(codepoint);
+    if(found != m_Characters.end())
+    {
+        if(found->second.size.x && found->second.size.y)
+            m_Pages[found->second.page].lastUsed = s_Frame;
+        return found->second;
+    }
 
-}
+    // Failures are cached as empty glyphs so they are not retried every frame.
+    FontCharacter character;
+    std::vector<unsigned char> pixels;
+    if(!m_Face && !m_FontData.empty())
+        Open();
+    if(!m_Face || !RenderGlyph((FT_Face)m_Face, codepoint, m_Rendering, character, pixels) || !character.size.x || !character.size.y)
+        return m_Characters[codepoint] = character;
 
-unsigned int FontBuilder::s_FontCreatorCount = 0;
-void *FontBuilder::s_FreetypeLibrary = nullptr;
+    glm::ivec2 origin;
+    unsigned int page_index;
+    if(!PlaceGlyph(glm::ivec2(character.size), page_index, origin))
+    {
+        // Every page is in use this frame; keep the spacing but draw nothing.
+        m_Unplaced = character;
+        m_Unplaced.size = glm::u16vec2(0);
+        return m_Unplaced;
+    }
+    character.position = glm::u16vec2(origin);
+    character.page = (uint16_t)page_index;
+
+    Page &page = m_Pages[page_index];
+    glBindTexture(GL_TEXTURE_2D, page.texture->GetTextureID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, origin.x, origin.y, character.size.x, character.size.y, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-FontBuilder::FontBuilder()
+    page.codepoints.push_back(codepoint);
+    page.lastUsed = s_Frame;
+    return m_Characters[codepoint] = character;
+}
+
+float Font::GetKerning(uint32_t left, uint32_t right)
 {
-    if(!s_FontCreatorCount) CreateFontContext();
-    s_FontCreatorCount++;
+    if(!m_HasKerning) return 0.0f;
+
+    int16_t adjustment;
+    if(m_Kerning.Find(left, right, adjustment))
+        return adjustment / 64.0f;
+    // Every nonzero ASCII pair was stored when the atlas was built.
+    if(left < 128 && right < 128)
+        return 0.0f;
+
+    if(!m_Face && !m_FontData.empty())
+        Open();
+    adjustment = m_Face ? KerningFor((FT_Face)m_Face, m_Gpos.get(), left, right) : 0;
+    m_Kerning.Insert(left, right, adjustment);
+    return adjustment / 64.0f;
 }
 
-FontBuilder::~FontBuilder()
+const Font::ShapedText &Font::Shape(std::string_view text)
 {
-    s_FontCreatorCount--;
-    if(!s_FontCreatorCount) DestroyFontContext();
+    const uint64_t key = HashBytes(text.data(), text.size());
+
+    auto found = m_Shapes.find(key);
+    if(found != m_Shapes.end() && found->second.text == text && found->second.complete)
+    {
+        found->second.lastUsed = s_Frame;
+        return found->second;
+    }
+
+    // Make room by dropping strings that were not drawn this frame. Results
+    // handed out this frame are never dropped, so the cache may briefly overflow.
+    if(found == m_Shapes.end() && m_Shapes.size() >= SHAPE_CACHE_SIZE)
+    {
+        for(auto it = m_Shapes.begin(); it != m_Shapes.end();)
+        {
+            if(it->second.lastUsed != s_Frame)
+                it = m_Shapes.erase(it);
+            else
+                it++;
+        }
+    }
+
+    ShapedText &shaped = m_Shapes[key];
+    shaped.text.assign(text.data(), text.size());
+    shaped.glyphs.clear();
+    shaped.width = 0.0f;
+    shaped.lastUsed = s_Frame;
+    shaped.complete = true;
+
+    float pen = 0.0f;
+    uint32_t previous = 0;
+    for(auto it = text.begin(); it != text.end();)
+    {
+        const uint32_t codepoint = DecodeUtf8(it, text.end());
+        if(previous)
+            pen += GetKerning(previous, codepoint);
+        previous = codepoint;
+
+        const FontCharacter &character = GetCharacter(codepoint);
+        if(IsUnplaced(character))
+            shaped.complete = false;
+        if(character.size.x && character.size.y)
+        {
+            shaped.glyphs.push_back(ShapedGlyph{ codepoint, pen });
+            shaped.width = std::max(shaped.width, pen + character.bearing.x + character.size.x - GetGlyphPadding());
+        }
+        pen += character.advance;
+    }
+    shaped.advance = pen;
+    return shaped;
 }
 
-std::shared_ptr<Font> FontBuilder::CreateFont(const std::string &font_path, int font_size)
+bool Font::PlaceGlyph(const glm::ivec2 &size, unsigned int &page, glm::ivec2 &origin)
 {
-    return std::make_shared<Font>(*this, font_path, font_size);
+    if(size.x + GLYPH_PADDING > m_PageSize || size.y + GLYPH_PADDING > m_PageSize)
+        return false;
+
+    for(page = 0; page < m_Pages.size(); page++)
+    {
+        if(PackGlyph(m_Pages[page].shelves, m_PageSize, size, origin))
+            return true;
+    }
+
+    if(m_Pages.size() < m_PageBudget)
+    {
+        AddPage(nullptr);
+        page = (unsigned int)m_Pages.size() - 1;
+        return PackGlyph(m_Pages[page].shelves, m_PageSize, size, origin);
+    }
+
+    // Out of budget: recycle the page that has gone unused the longest.
+    int victim = -1;
+    for(unsigned int i = 0; i < m_Pages.size(); i++)
+    {
+        if(m_Pages[i].lastUsed != s_Frame && (victim < 0 || m_Pages[i].lastUsed < m_Pages[victim].lastUsed))
+            victim = i;
+    }
+    if(victim < 0)
+        return false;
+
+    ClearPage(victim);
+    page = victim;
+    return PackGlyph(m_Pages[page].shelves, m_PageSize, size, origin);
 }
 
-void FontBuilder::CreateFontContext()
+void Font::AddPage(const unsigned char *pixels)
 {
-    if (FT_Init_FreeType((FT_Library*)&s_FreetypeLibrary))
+    std::vector<unsigned char> blank;
+    if(!pixels)
     {
-        SDL_Log("Cannot Init FreeType!\n");
-        return;
+        blank.assign((size_t)m_PageSize * m_PageSize, 0);
+        pixels = blank.data();
     }
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GL_R8,
+        m_PageSize,
+        m_PageSize,
+        0,
+        GL_RED,
+        GL_UNSIGNED_BYTE,
+        pixels
+    );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    Page page;
+    page.texture = std::make_shared<FontTexture>(texture, m_PageSize);
+    page.lastUsed = s_Frame;
+    m_Pages.push_back(std::move(page));
+}
+
+void Font::ClearPage(unsigned int page)
+{
+    Page &cleared = m_Pages[page];
+    m_Generation++;
+    for(uint32_t codepoint : cleared.codepoints)
+        m_Characters.erase(codepoint);
+    cleared.codepoints.clear();
+    cleared.shelves.clear();
+
+    std::vector<unsigned char> blank((size_t)m_PageSize * m_PageSize, 0);
+    glBindTexture(GL_TEXTURE_2D, cleared.texture->GetTextureID());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_PageSize, m_PageSize, GL_RED, GL_UNSIGNED_BYTE, blank.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Font::Reload(FontAtlas &&atlas, const std::string &debug_name)
+{
+    Adopt(std::move(atlas), debug_name);
 }
 
-void FontBuilder::DestroyFontContext()
+Font::~Font()
+{
+    if(m_Face) CloseFace((FT_Library)m_Library, (FT_Face)m_Face);
+}
+
+Font::FontTexture::FontTexture(unsigned int textureID, unsigned int size)
+    : Texture(textureID, glm::ivec2(size), 1)
 {
-    FT_Done_FreeType((FT_Library)s_FreetypeLibrary);
-    s_FreetypeLibrary = nullptr;
+
+}
+
+std::shared_ptr<Font> FontBuilder::CreateFont(const std::string &font_path, int font_size)
+{
+    return std::make_shared<Font>(*this, font_path, font_size);
 }
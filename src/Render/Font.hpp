@@ -1,54 +1,187 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
-#include <array>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
 
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/ext/vector_int2_sized.hpp>
+#include <glm/ext/vector_uint2_sized.hpp>
 
 #include "Texture.hpp"
+#include "Kerning.hpp"
 
 class Font;
+class MappedFile;
 
+// Every Font owns its FreeType instance, since FT_Library objects must not be
+// shared between threads. The builder is kept as a convenience factory.
 class FontBuilder
 {
-private:
-    static unsigned int s_FontCreatorCount;
-    static void* s_FreetypeLibrary;
 public:
-    FontBuilder();
+    FontBuilder() = default;
     FontBuilder(const FontBuilder&) = delete;
-    ~FontBuilder();
     std::shared_ptr<Font> CreateFont(const std::string &font_path, int font_size);
-private:
-    void CreateFontContext();
-    void DestroyFontContext();
-    friend class Font;
 };
 
+// Glyphs are rasterized on first use and shelf-packed into atlas pages. When
+// every page is full, the least recently used page is cleared and refilled.
 class Font {
 public:
+    // Bitmap fonts are sharp at their own size only. Distance-field fonts store
+    // the distance to the glyph outline and are drawn at any size with the text shader.
+    enum class Rendering { Bitmap, DistanceField };
+    // 16 bytes per glyph. Metrics are whole pixels at the font's own size and
+    // the atlas position is in texels; GetUV turns it into texture coordinates.
     struct FontCharacter {
-        glm::ivec2 size;
-        glm::ivec2 bearing;
-        signed long advance;
-        glm::vec2 bottomLeftUV;
-        glm::vec2 topRightUV;
+        glm::u16vec2 position;
+        glm::u16vec2 size;
+        glm::i16vec2 bearing;
+        int16_t advance;
+        uint16_t page;
+    };
+    struct Shelf {
+        unsigned int y, height, x;
+    };
+    // Advance adjustment between two codepoints, in 1/64 pixel at the font's own size.
+    struct KerningPair {
+        uint32_t left, right;
+        int16_t adjustment;
+    };
+    // A string decoded and kerned once. Positions are pixels at the font's own size.
+    struct ShapedGlyph {
+        uint32_t codepoint;
+        float x;
+    };
+    struct ShapedText {
+        std::string text;
+        // Only glyphs that draw something.
+        std::vector<ShapedGlyph> glyphs;
+        // Where the pen ends up, and where the rightmost glyph bitmap ends.
+        float advance = 0.0f, width = 0.0f;
+        unsigned int lastUsed = 0;
+        // False when a glyph found no room in the atlas. Such a shape is
+        // redone on its next use, once the atlas may have room again.
+        bool complete = true;
     };
+    // The first atlas page, one coverage or distance byte per texel, with the
+    // printable ASCII range already rasterized.
+    // Rasterize touches no GL state and may run on any thread. It spreads the
+    // glyphs over the job system and composes the page on the calling thread.
+    struct FontAtlas {
+        int fontSize = 0;
+        Rendering rendering = Rendering::Bitmap;
+        unsigned int pageSize = 0;
+        unsigned int lineHeight = 0;
+        std::vector<unsigned char> fontData;
+        std::vector<unsigned char> pixels;
+        std::vector<Shelf> shelves;
+        std::vector<std::pair<uint32_t, FontCharacter>> characters;
+        // Whether the font kerns at all, and every nonzero pair within the printable ASCII range.
+        bool kerning = false;
+        std::vector<KerningPair> kerningPairs;
+        // Set instead of pixels when the atlas comes from a cache file; the
+        // page is uploaded straight from the mapping.
+        std::shared_ptr<const MappedFile> cacheFile;
+        const unsigned char *cachePixels = nullptr;
+
+        inline const unsigned char *GetPixels() const { return cachePixels ? cachePixels : pixels.data(); }
+    };
+    static const unsigned int DEFAULT_PAGE_BUDGET = 4;
+    // Reference size for distance-field fonts, large enough to keep corners crisp when scaled up.
+    static const int DISTANCE_FIELD_SIZE = 48;
+    // How far, in atlas texels, the distance field extends past each glyph outline.
+    // This bounds how wide outlines and shadows can be at the reference size.
+    static const int DISTANCE_FIELD_SPREAD = 8;
+    // Strings kept by Shape before those not drawn this frame are dropped.
+    static const size_t SHAPE_CACHE_SIZE = 1024;
 public:
     Font(const FontBuilder &fontBuilder, const std::string &font_path, int font_size);
+    Font(const FontBuilder &fontBuilder, const unsigned char *font_data, long font_data_size, int font_size, const std::string &debug_name = "");
+    Font(FontAtlas &&atlas, const std::string &debug_name = "");
     Font(const Font&) = delete;
-    inline std::shared_ptr<Texture> GetTexture() const { return m_Texture; };
-    const FontCharacter &GetCharacter(unsigned char c) const;
+    static bool Rasterize(const unsigned char *font_data, long font_data_size, int font_size, FontAtlas &atlas, const std::string &debug_name = "", Rendering rendering = Rendering::Bitmap);
+    // Identifies the FreeType build, since atlases cached by another version may differ.
+    static uint32_t GetRasterizerVersion();
+    // Swaps in an atlas rasterized elsewhere, usually by a job. Every page is
+    // recreated, so the generation changes and cached glyphs are dropped.
+    void Reload(FontAtlas &&atlas, const std::string &debug_name = "");
+    // Looks the glyph up, rasterizing it into the atlas if it is not cached.
+    const FontCharacter &GetCharacter(uint32_t codepoint);
+    // True for a glyph GetCharacter found no atlas room for this frame. It
+    // keeps its advance but draws nothing, and is looked up again next time.
+    inline bool IsUnplaced(const FontCharacter &character) const { return &character == &m_Unplaced; }
+    // Extra advance after left when right follows it, in pixels at the font's own size.
+    // Pairs outside printable ASCII are looked up on first use and remembered.
+    float GetKerning(uint32_t left, uint32_t right);
+    inline bool HasKerning() const { return m_HasKerning; }
+    // Decodes and kerns UTF-8 text, memoized per string so text drawn every
+    // frame is only shaped once. The result stays valid until the next frame.
+    const ShapedText &Shape(std::string_view text);
+    inline const std::shared_ptr<Texture> &GetTexture(unsigned int page) const { return m_Pages[page].texture; }
+    inline unsigned int GetPageCount() const { return (unsigned int)m_Pages.size(); }
     inline unsigned int GetFontSize() const { return m_FontSize; }
+    // Atlas rectangle of a glyph as (left, top, right, bottom) texture coordinates.
+    inline glm::vec4 GetUV(const FontCharacter &character) const
+    {
+        const float texel = 1.0f / m_PageSize;
+        return glm::vec4(character.position.x, character.position.y, character.position.x + character.size.x, character.position.y + character.size.y) * texel;
+    }
+    // Baseline-to-baseline distance at the font's own size.
+    inline unsigned int GetLineHeight() const { return m_LineHeight; }
+    // Changes whenever glyphs are evicted or the font is reloaded, which
+    // invalidates any atlas coordinates copied out of GetCharacter.
+    inline unsigned int GetGeneration() const { return m_Generation; }
+    // Marks a page as used this frame without looking up a glyph.
+    inline void TouchPage(unsigned int page) { m_Pages[page].lastUsed = s_Frame; }
+    inline Rendering GetRendering() const { return m_Rendering; }
+    // Empty texels around every glyph bitmap that are not part of the glyph itself.
+    inline int GetGlyphPadding() const { return m_Rendering == Rendering::DistanceField ? DISTANCE_FIELD_SPREAD : 0; }
+    // Caps how many atlas pages this font may allocate before it starts evicting.
+    inline void SetPageBudget(unsigned int pages) { m_PageBudget = pages ? pages : 1; }
+    // Pages touched since the last call are never evicted, so glyphs already
+    // batched for the current frame stay valid. The renderer calls this once per frame.
+    static void AdvanceFrame() { s_Frame++; }
     ~Font();
 private:
+    struct Page {
+        std::shared_ptr<Texture> texture;
+        std::vector<Shelf> shelves;
+        std::vector<uint32_t> codepoints;
+        unsigned int lastUsed = 0;
+    };
+    static unsigned int s_Frame;
+    bool Open();
+    void Adopt(FontAtlas &&atlas, const std::string &debug_name);
+    bool PlaceGlyph(const glm::ivec2 &size, unsigned int &page, glm::ivec2 &origin);
+    void AddPage(const unsigned char *pixels);
+    void ClearPage(unsigned int page);
     class FontTexture : public Texture
     {
     public:
         FontTexture(unsigned int textureID, unsigned int size);
     };
-    std::unique_ptr<FontCharacter[]> m_Characters;
-    std::shared_ptr<FontTexture> m_Texture;
+    std::vector<unsigned char> m_FontData;
+    std::string m_Name;
+    // Opened on the first glyph missing from the atlas, so cached fonts never load FreeType.
+    void *m_Library = nullptr;
+    void *m_Face = nullptr;
+    std::unique_ptr<GposKerning> m_Gpos;
+    KerningTable m_Kerning;
+    bool m_HasKerning = false;
+    std::unordered_map<uint64_t, ShapedText> m_Shapes;
+    std::unordered_map<uint32_t, FontCharacter> m_Characters;
+    std::vector<Page> m_Pages;
+    FontCharacter m_Unplaced;
     unsigned int m_FontSize;
-};
\ No newline at end of file
+    unsigned int m_LineHeight = 0;
+    unsigned int m_Generation = 0;
+    Rendering m_Rendering = Rendering::Bitmap;
+    unsigned int m_PageSize = 0;
+    unsigned int m_PageBudget = DEFAULT_PAGE_BUDGET;
+};
@@ -0,0 +1,270 @@
+#include "Kerning.hpp"
+
+#include <algorithm>
+
+// OpenType lookup types for pair adjustment and for extension subtables,
+// which wrap another type behind a 32-bit offset.
+static const uint16_t LOOKUP_PAIR_ADJUSTMENT = 2;
+static const uint16_t LOOKUP_EXTENSION = 9;
+static const uint16_t VALUE_X_ADVANCE = 0x0004;
+
+static unsigned int ValueRecordSize(uint16_t value_format)
+{
+    unsigned int size = 0;
+    for(uint16_t bits = value_format & 0xFF; bits; bits &= bits - 1)
+        size += 2;
+    return size;
+}
+
+// Byte offset of XAdvance inside a value record, which only holds the fields its format names.
+static unsigned int XAdvanceOffset(uint16_t value_format)
+{
+    return ValueRecordSize(value_format & (VALUE_X_ADVANCE - 1));
+}
+
+bool GposKerning::Load(const unsigned char *table, size_t size)
+{
+    m_Table.assign(table, table + size);
+    m_Lookups.clear();
+    if(!InRange(0, 10) || U16(0) != 1)
+        return false;
+
+    const uint32_t feature_list = U16(6);
+    const uint32_t lookup_list = U16(8);
+
+    // Kerning is whatever the 'kern' feature uses, for any script or language.
+    std::vector<uint16_t> lookups;
+    const uint16_t feature_count = U16(feature_list);
+    for(uint16_t i = 0; i < feature_count; i++)
+    {
+        const uint32_t record = feature_list + 2 + i * 6;
+        if(!InRange(record, 6) || m_Table[record] != 'k' || m_Table[record + 1] != 'e' || m_Table[record + 2] != 'r' || m_Table[record + 3] != 'n')
+            continue;
+        const uint32_t feature = feature_list + U16(record + 4);
+        const uint16_t index_count = U16(feature + 2);
+        for(uint16_t j = 0; j < index_count; j++)
+            lookups.push_back(U16(feature + 4 + j * 2));
+    }
+    std::sort(lookups.begin(), lookups.end());
+    lookups.erase(std::unique(lookups.begin(), lookups.end()), lookups.end());
+
+    const uint16_t lookup_count = U16(lookup_list);
+    for(uint16_t lookup : lookups)
+    {
+        if(lookup < lookup_count)
+            AddLookup(lookup_list + U16(lookup_list + 2 + lookup * 2));
+    }
+    return !m_Lookups.empty();
+}
+
+void GposKerning::AddLookup(uint32_t lookup_offset)
+{
+    const uint16_t type = U16(lookup_offset);
+    const uint16_t subtable_count = U16(lookup_offset + 4);
+    std::vector<uint32_t> subtables;
+    for(uint16_t i = 0; i < subtable_count; i++)
+    {
+        uint32_t subtable = lookup_offset + U16(lookup_offset + 6 + i * 2);
+        if(type == LOOKUP_EXTENSION)
+        {
+            if(U16(subtable + 2) != LOOKUP_PAIR_ADJUSTMENT)
+                continue;
+            subtable += U32(subtable + 4);
+        }
+        else if(type != LOOKUP_PAIR_ADJUSTMENT)
+            continue;
+
+        const uint16_t format = U16(subtable);
+        if((format == 1 || format == 2) && InRange(subtable, 10))
+            subtables.push_back(subtable);
+    }
+    if(!subtables.empty())
+        m_Lookups.push_back(std::move(subtables));
+}
+
+int GposKerning::GetAdjustment(uint16_t left_glyph, uint16_t right_glyph) const
+{
+    // Every lookup applies on its own; inside one, the first matching subtable wins.
+    int adjustment = 0;
+    for(const std::vector<uint32_t> &subtables : m_Lookups)
+    {
+        for(uint32_t subtable : subtables)
+        {
+            bool matched = false;
+            adjustment += GetSubtableAdjustment(subtable, left_glyph, right_glyph, matched);
+            if(matched)
+                break;
+        }
+    }
+    return adjustment;
+}
+
+int GposKerning::GetSubtableAdjustment(uint32_t subtable, uint16_t left_glyph, uint16_t right_glyph, bool &matched) const
+{
+    const int coverage_index = CoverageIndex(subtable + U16(subtable + 2), left_glyph);
+    if(coverage_index < 0)
+        return 0;
+
+    const uint16_t value_format1 = U16(subtable + 4);
+    const uint16_t value_format2 = U16(subtable + 6);
+    const unsigned int record_size = ValueRecordSize(value_format1) + ValueRecordSize(value_format2);
+
+    uint32_t value = 0;
+    if(U16(subtable) == 1)
+    {
+        if(coverage_index >= U16(subtable + 8))
+            return 0;
+        const uint32_t pair_set = subtable + U16(subtable + 10 + coverage_index * 2);
+        const unsigned int pair_size = 2 + record_size;
+
+        // Pair records are sorted by their second glyph.
+        int low = 0, high = (int)U16(pair_set) - 1;
+        while(low <= high)
+        {
+            const int middle = (low + high) / 2;
+            const uint32_t record = pair_set + 2 + middle * pair_size;
+            const uint16_t glyph = U16(record);
+            if(glyph == right_glyph)
+            {
+                value = record + 2;
+                break;
+            }
+            if(glyph < right_glyph)
+                low = middle + 1;
+            else
+                high = middle - 1;
+        }
+        if(!value)
+            return 0;
+    }
+    else
+    {
+        const unsigned int class1 = GlyphClass(subtable + U16(subtable + 8), left_glyph);
+        const unsigned int class2 = GlyphClass(subtable + U16(subtable + 10), right_glyph);
+        const uint16_t class1_count = U16(subtable + 12);
+        const uint16_t class2_count = U16(subtable + 14);
+        if(class1 >= class1_count || class2 >= class2_count)
+            return 0;
+        value = subtable + 16 + (class1 * class2_count + class2) * record_size;
+    }
+
+    matched = true;
+    if(!(value_format1 & VALUE_X_ADVANCE))
+        return 0;
+    return (int16_t)U16(value + XAdvanceOffset(value_format1));
+}
+
+int GposKerning::CoverageIndex(uint32_t coverage, uint16_t glyph) const
+{
+    const uint16_t format = U16(coverage);
+    const uint16_t count = U16(coverage + 2);
+    int low = 0, high = (int)count - 1;
+    while(low <= high)
+    {
+        const int middle = (low + high) / 2;
+        if(format == 1)
+        {
+            const uint16_t covered = U16(coverage + 4 + middle * 2);
+            if(covered == glyph)
+                return middle;
+            if(covered < glyph)
+                low = middle + 1;
+            else
+                high = middle - 1;
+        }
+        else if(format == 2)
+        {
+            const uint32_t range = coverage + 4 + middle * 6;
+            if(glyph < U16(range))
+                high = middle - 1;
+            else if(glyph > U16(range + 2))
+                low = middle + 1;
+            else
+                return U16(range + 4) + glyph - U16(range);
+        }
+        else
+            break;
+    }
+    return -1;
+}
+
+unsigned int GposKerning::GlyphClass(uint32_t class_def, uint16_t glyph) const
+{
+    const uint16_t format = U16(class_def);
+    if(format == 1)
+    {
+        const uint16_t first = U16(class_def + 2);
+        if(glyph < first || glyph - first >= U16(class_def + 4))
+            return 0;
+        return U16(class_def + 6 + (glyph - first) * 2);
+    }
+    if(format == 2)
+    {
+        int low = 0, high = (int)U16(class_def + 2) - 1;
+        while(low <= high)
+        {
+            const int middle = (low + high) / 2;
+            const uint32_t range = class_def + 4 + middle * 6;
+            if(glyph < U16(range))
+                high = middle - 1;
+            else if(glyph > U16(range + 2))
+                low = middle + 1;
+            else
+                return U16(range + 4);
+        }
+    }
+    return 0;
+}
+
+void KerningTable::Clear()
+{
+    m_Keys.clear();
+    m_Values.clear();
+    m_Count = 0;
+}
+
+size_t KerningTable::Slot(uint64_t key) const
+{
+    // Mix both codepoints so neighbouring pairs spread across the table.
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    size_t slot = (size_t)(hash >> 32) & (m_Keys.size() - 1);
+    while(m_Keys[slot] != EMPTY && m_Keys[slot] != key)
+        slot = (slot + 1) & (m_Keys.size() - 1);
+    return slot;
+}
+
+void KerningTable::Insert(uint32_t left, uint32_t right, int16_t adjustment)
+{
+    // Stay at most half full so probes stay short.
+    if((m_Count + 1) * 2 > m_Keys.size())
+    {
+        std::vector<uint64_t> keys = std::move(m_Keys);
+        std::vector<int16_t> values = std::move(m_Values);
+        m_Keys.assign(std::max<size_t>(64, keys.size() * 2), EMPTY);
+        m_Values.assign(m_Keys.size(), 0);
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            if(keys[i] == EMPTY) continue;
+            const size_t slot = Slot(keys[i]);
+            m_Keys[slot] = keys[i];
+            m_Values[slot] = values[i];
+        }
+    }
+
+    const uint64_t key = Key(left, right);
+    const size_t slot = Slot(key);
+    if(m_Keys[slot] == EMPTY)
+        m_Count++;
+    m_Keys[slot] = key;
+    m_Values[slot] = adjustment;
+}
+
+bool KerningTable::Find(uint32_t left, uint32_t right, int16_t &adjustment) const
+{
+    if(!m_Count) return false;
+    const size_t slot = Slot(Key(left, right));
+    if(m_Keys[slot] == EMPTY)
+        return false;
+    adjustment = m_Values[slot];
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Horizontal kerning from the pair adjustment lookups of an OpenType GPOS
+// 'kern' feature. Most current fonts only kern through GPOS, which
+// FT_Get_Kerning does not read.
+class GposKerning
+{
+private:
+    std::vector<unsigned char> m_Table;
+    // Offsets of the pair adjustment subtables of each 'kern' lookup, in lookup order.
+    std::vector<std::vector<uint32_t>> m_Lookups;
+public:
+    // Takes the raw GPOS table. Returns false if it has no usable kerning.
+    bool Load(const unsigned char *table, size_t size);
+    inline bool IsEmpty() const { return m_Lookups.empty(); }
+    // Advance adjustment for the left glyph, in font units.
+    int GetAdjustment(uint16_t left_glyph, uint16_t right_glyph) const;
+private:
+    void AddLookup(uint32_t lookup_offset);
+    int GetSubtableAdjustment(uint32_t subtable, uint16_t left_glyph, uint16_t right_glyph, bool &matched) const;
+    int CoverageIndex(uint32_t coverage, uint16_t glyph) const;
+    unsigned int GlyphClass(uint32_t class_def, uint16_t glyph) const;
+    inline bool InRange(uint32_t offset, uint32_t size) const { return (uint64_t)offset + size <= m_Table.size(); }
+    inline uint16_t U16(uint32_t offset) const { return InRange(offset, 2) ? (uint16_t)(m_Table[offset] << 8 | m_Table[offset + 1]) : 0; }
+    inline uint32_t U32(uint32_t offset) const { return (uint32_t)U16(offset) << 16 | U16(offset + 2); }
+};
+
+// Open-addressing map from a codepoint pair to an advance adjustment in 1/64
+// pixel, sized for the few thousand pairs a font actually kerns.
+class KerningTable
+{
+private:
+    static constexpr uint64_t EMPTY = ~0ull;
+    std::vector<uint64_t> m_Keys;
+    std::vector<int16_t> m_Values;
+    size_t m_Count = 0;
+public:
+    void Clear();
+    void Insert(uint32_t left, uint32_t right, int16_t adjustment);
+    bool Find(uint32_t left, uint32_t right, int16_t &adjustment) const;
+    inline size_t GetSize() const { return m_Count; }
+private:
+    static inline uint64_t Key(uint32_t left, uint32_t right) { return (uint64_t)left << 32 | right; }
+    size_t Slot(uint64_t key) const;
+};
@@ -12,6 +12,21 @@
 
 #include "../Input.hpp"
 #include "../Game.hpp"
+#include "../Resource/ResourceManager.hpp"
+#include "../Core/FramePacer.hpp"
+#include "../Core/FrameArena.hpp"
+#include "TextLayout.hpp"
+#include "TextConsole.hpp"
+
+static const char *s_2DVertexShaderPath = "asset/shader/color_vert.glsl";
+static const char *s_2DFragmentShaderPath = "asset/shader/color_frag.glsl";
+static const char *s_TextFragmentShaderPath = "asset/shader/text_frag.glsl";
+
+void Renderer::Preload()
+{
+    ResourceManager::Get().PrefetchShader(s_2DVertexShaderPath, s_2DFragmentShaderPath);
+    ResourceManager::Get().PrefetchShader(s_2DVertexShaderPath, s_TextFragmentShaderPath);
+}
 
 void Renderer::Init(SDL_Window *pWindow)
 {
@@ -41,10 +56,12 @@ void Renderer::Init(SDL_Window *pWindow)
 
     CreateQuadBuffer(MAX_QUADS);
 
-    m_2DShader = std::make_unique<Shader>("asset/shader/color_vert.glsl", "asset/shader/color_frag.glsl");
-    m_2DShader->Bind();
-    int textures[MAX_TEXTURE_IMAGE_UNITS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
-    m_2DShader->SetIntArray("u_Textures", MAX_TEXTURE_IMAGE_UNITS, textures);
+    m_2DShader = ResourceManager::Get().LoadShader(s_2DVertexShaderPath, s_2DFragmentShaderPath);
+    m_2DShaderRevision = ~0u;
+    m_TextShader = ResourceManager::Get().LoadShader(s_2DVertexShaderPath, s_TextFragmentShaderPath);
+    m_TextShaderRevision = ~0u;
+    m_BatchShader = BatchShader::Sprite;
+    m_PremultipliedBatch = false;
     m_iDrawCalls = 0;
 
     m_TextureSlots.fill(~0u);
@@ -60,9 +77,19 @@ void Renderer::Init(SDL_Window *pWindow)
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glEnable(GL_BLEND);
     
-    SDL_GL_SetSwapInterval(1);
+    FramePacer::Get().Init(m_pWindow);
 
     glEnable(GL_SCISSOR_TEST);
+
+    // A shader whose sources are missing never loads; its batches are skipped.
+    Shader *shader = ResourceManager::Get().GetShader(m_2DShader);
+    if(!shader)
+    {
+        SDL_Log("Failed to load the 2D shader, sprites will not be drawn!\n");
+        return;
+    }
+    shader->Bind();
+    BindTextureUnits(*shader, m_2DShaderRevision);
 }
 
 void Renderer::RenderBegin()
@@ -92,16 +119,17 @@ void Renderer::RenderBegin()
     glScissor(left , bottom, width, height);
 }
 
-void Renderer::RenderTexturedQuad(std::shared_ptr<Texture> sprite, const glm::mat4 &transform)
+void Renderer::RenderTexturedQuad(const Texture &sprite, const glm::mat4 &transform)
 {
-    int slot = GetBufferTextureSlot(sprite->GetTextureID());
+    UseBatchShader(BatchShader::Sprite, sprite.IsPremultiplied());
+    int slot = GetBufferTextureSlot(sprite.GetTextureID());
 
-    glm::vec4 bottom_left  = transform * glm::vec4(-sprite->GetWidth() / 2.0f, -sprite->GetHeight() / 2.0f, 0.0f, 1.0f);
-    glm::vec4 bottom_right = transform * glm::vec4( sprite->GetWidth() / 2.0f, -sprite->GetHeight() / 2.0f, 0.0f, 1.0f);
-    glm::vec4 top_right    = transform * glm::vec4( sprite->GetWidth() / 2.0f,  sprite->GetHeight() / 2.0f, 0.0f, 1.0f);
-    glm::vec4 top_left     = transform * glm::vec4(-sprite->GetWidth() / 2.0f,  sprite->GetHeight() / 2.0f, 0.0f, 1.0f);
+    glm::vec4 bottom_left  = transform * glm::vec4(-sprite.GetWidth() / 2.0f, -sprite.GetHeight() / 2.0f, 0.0f, 1.0f);
+    glm::vec4 bottom_right = transform * glm::vec4( sprite.GetWidth() / 2.0f, -sprite.GetHeight() / 2.0f, 0.0f, 1.0f);
+    glm::vec4 top_right    = transform * glm::vec4( sprite.GetWidth() / 2.0f,  sprite.GetHeight() / 2.0f, 0.0f, 1.0f);
+    glm::vec4 top_left     = transform * glm::vec4(-sprite.GetWidth() / 2.0f,  sprite.GetHeight() / 2.0f, 0.0f, 1.0f);
 
-    const Texture::TextureUV& uv = sprite->GetUV();
+    const Texture::TextureUV& uv = sprite.GetUV();
     const glm::vec2& bottomLeftUV = uv.bottomLeft;
     const glm::vec2& topRightUV = uv.topRight;
 
@@ -115,8 +143,21 @@ void Renderer::RenderTexturedQuad(std::shared_ptr<Texture> sprite, const glm::ma
         DrawQuadBuffer();
 }
 
+void Renderer::RenderTexturedQuad(TextureHandle texture, const glm::mat4 &transform)
+{
+    const Texture *sprite = ResourceManager::Get().GetTexture(texture);
+    if(sprite) RenderTexturedQuad(*sprite, transform);
+}
+
+void Renderer::RenderTexturedQuad(SubTextureHandle texture, const glm::mat4 &transform)
+{
+    const SubTexture *sprite = ResourceManager::Get().GetSubTexture(texture);
+    if(sprite) RenderTexturedQuad(*sprite, transform);
+}
+
 void Renderer::RenderQuad(const glm::mat4 &transform, const glm::vec4 &color)
 {
+    UseBatchShader(BatchShader::Sprite);
     glm::vec4 bottom_left  = transform * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
     glm::vec4 bottom_right = transform * glm::vec4( 1.0f, -1.0f, 0.0f, 1.0f);
     glm::vec4 top_right    = transform * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f);
@@ -132,21 +173,22 @@ void Renderer::RenderQuad(const glm::mat4 &transform, const glm::vec4 &color)
         DrawQuadBuffer();
 }
 
-void Renderer::RenderText(const glm::ivec2 &position, std::shared_ptr<Font> font, const std::string &text, const glm::vec4 &color, TextHAlign halign, TextVAlign valign)
+void Renderer::RenderText(const glm::ivec2 &position, Font &font, float size, std::string_view text, const glm::vec4 &color, TextHAlign halign, TextVAlign valign)
 {
-    int slot = GetBufferTextureSlot(font->GetTexture()->GetTextureID());
+    UseBatchShader(font.GetRendering() == Font::Rendering::DistanceField ? BatchShader::DistanceFieldText : BatchShader::BitmapText);
 
-    unsigned int x_pos = position.x;
-    unsigned int y_pos = (int)Renderer::Get().GetGameSize().y - position.y;
+    const float scale = size / font.GetFontSize();
+    float x_pos = (float)position.x;
+    float y_pos = Renderer::Get().GetGameSize().y - position.y;
 
     float y_offset = 0.0f;
     switch(valign)
     {
         case TextVAlign::Top:
-            y_offset = -(float)font->GetFontSize();
+            y_offset = -size;
             break;
         case TextVAlign::Center:
-            y_offset = -(float)font->GetFontSize() / 2.0f;
+            y_offset = -size / 2.0f;
             break;
         case TextVAlign::Bottom:
             y_offset = 0.0f;
@@ -160,53 +202,183 @@ void Renderer::RenderText(const glm::ivec2 &position, std::shared_ptr<Font> font
         x_offset = 0.0f;
         break;
     case TextHAlign::Center:
-        x_offset = -CalculateTextSize(font, text).x / 2.0f;
+        x_offset = -CalculateTextSize(font, size, text).x / 2.0f;
         break;
     case TextHAlign::Right:
-        x_offset = (float)-CalculateTextSize(font, text).x;
+        x_offset = (float)-CalculateTextSize(font, size, text).x;
         break;
     }
     
 
-    for(char c : text)
+    RenderGlyphs(font, scale, glm::vec2(x_pos + x_offset, y_pos + y_offset), font.Shape(text), color);
+}
+
+void Renderer::RenderGlyphs(Font &font, float scale, const glm::vec2 &pen, const Font::ShapedText &text, const glm::vec4 &color)
+{
+    // Glyphs can live on different atlas pages; only look the slot up again when the page changes.
+    unsigned int texture = ~0u;
+    int slot = 0;
+    for(const Font::ShapedGlyph &glyph : text.glyphs)
     {
-        const Font::FontCharacter &character = font->GetCharacter(c);
+        const Font::FontCharacter &character = font.GetCharacter(glyph.codepoint);
+        if(character.size.x && character.size.y)
+        {
+            const unsigned int page_texture = font.GetTexture(character.page)->GetTextureID();
+            if(page_texture != texture)
+            {
+                texture = page_texture;
+                slot = GetBufferTextureSlot(texture);
+            }
+
+            const float left   = pen.x + (glyph.x + character.bearing.x) * scale;
+            const float right  = left + character.size.x * scale;
+            const float bottom = pen.y - (character.size.y - character.bearing.y) * scale;
+            const float top    = bottom + character.size.y * scale;
+            // Atlas rows run top to bottom, so the top of the quad samples the smaller v.
+            const glm::vec4 uv = font.GetUV(character);
+
+            m_Vertices[0 + m_QuadCount * 4] = Vertex{ glm::vec2(left,  bottom), glm::vec2(uv.x, uv.w), color, (float)slot };
+            m_Vertices[1 + m_QuadCount * 4] = Vertex{ glm::vec2(right, bottom), glm::vec2(uv.z, uv.w), color, (float)slot };
+            m_Vertices[2 + m_QuadCount * 4] = Vertex{ glm::vec2(right, top),    glm::vec2(uv.z, uv.y), color, (float)slot };
+            m_Vertices[3 + m_QuadCount * 4] = Vertex{ glm::vec2(left,  top),    glm::vec2(uv.x, uv.y), color, (float)slot };
+            m_QuadCount++;
+
+            if(m_QuadCount == MAX_QUADS) {
+                DrawQuadBuffer();
+                texture = ~0u;
+            }
+        }
+    }
+}
 
-        m_Vertices[0 + m_QuadCount * 4] = Vertex{ glm::vec2(x_pos                    + x_offset, y_pos + y_offset - (character.size.y - character.bearing.y)), glm::vec2(character.bottomLeftUV.x, character.topRightUV.y), color, (float)slot };
-        m_Vertices[1 + m_QuadCount * 4] = Vertex{ glm::vec2(x_pos + character.size.x + x_offset, y_pos + y_offset - (character.size.y - character.bearing.y)), glm::vec2(character.topRightUV.x,   character.topRightUV.y), color, (float)slot };
-        m_Vertices[2 + m_QuadCount * 4] = Vertex{ glm::vec2(x_pos + character.size.x + x_offset, y_pos + y_offset - (character.size.y - character.bearing.y) + character.size.y), glm::vec2(character.topRightUV.x,   character.bottomLeftUV.y), color, (float)slot };
-        m_Vertices[3 + m_QuadCount * 4] = Vertex{ glm::vec2(x_pos                    + x_offset, y_pos + y_offset - (character.size.y - character.bearing.y) + character.size.y), glm::vec2(character.bottomLeftUV.x, character.bottomLeftUV.y), color, (float)slot };
-        m_QuadCount++;
+void Renderer::RenderText(const glm::ivec2 &position, FontHandle font, float size, std::string_view text, const glm::vec4 &color, TextHAlign halign, TextVAlign valign)
+{
+    Font *pFont = ResourceManager::Get().GetFont(font);
+    if(pFont) RenderText(position, *pFont, size, text, color, halign, valign);
+}
+
+void Renderer::RenderText(const glm::ivec2 &position, Font &font, std::string_view text, const glm::vec4 &color, TextHAlign halign, TextVAlign valign)
+{
+    RenderText(position, font, (float)font.GetFontSize(), text, color, halign, valign);
+}
+
+void Renderer::RenderText(const glm::ivec2 &position, FontHandle font, std::string_view text, const glm::vec4 &color, TextHAlign halign, TextVAlign valign)
+{
+    Font *pFont = ResourceManager::Get().GetFont(font);
+    if(pFont) RenderText(position, *pFont, text, color, halign, valign);
+}
+
+void Renderer::RenderText(const glm::ivec2 &position, TextLayout &layout, const glm::vec4 &color)
+{
+    Font *font = layout.Update();
+    if(!font) return;
+
+    UseBatchShader(font->GetRendering() == Font::Rendering::DistanceField ? BatchShader::DistanceFieldText : BatchShader::BitmapText);
+
+    // The cached quads skip GetCharacter, so keep their pages from being evicted this frame.
+    for(unsigned int page : layout.GetPages())
+        font->TouchPage(page);
 
-        x_pos += character.advance >> 6;
+    const glm::vec2 origin((float)position.x, GetGameSize().y - position.y);
+    unsigned int page = ~0u;
+    int slot = 0;
+    for(const TextLayout::Glyph &glyph : layout.GetGlyphs())
+    {
+        if(glyph.page != page)
+        {
+            page = glyph.page;
+            slot = GetBufferTextureSlot(font->GetTexture(page)->GetTextureID());
+        }
+
+        const glm::vec2 bottom_left = origin + glyph.bottomLeft;
+        const glm::vec2 top_right = origin + glyph.topRight;
+        m_Vertices[0 + m_QuadCount * 4] = Vertex{ bottom_left,                          glyph.bottomLeftUV,                                    color, (float)slot };
+        m_Vertices[1 + m_QuadCount * 4] = Vertex{ glm::vec2(top_right.x, bottom_left.y), glm::vec2(glyph.topRightUV.x, glyph.bottomLeftUV.y), color, (float)slot };
+        m_Vertices[2 + m_QuadCount * 4] = Vertex{ top_right,                            glyph.topRightUV,                                      color, (float)slot };
+        m_Vertices[3 + m_QuadCount * 4] = Vertex{ glm::vec2(bottom_left.x, top_right.y), glm::vec2(glyph.bottomLeftUV.x, glyph.topRightUV.y), color, (float)slot };
+        m_QuadCount++;
 
         if(m_QuadCount == MAX_QUADS) {
             DrawQuadBuffer();
-            slot = GetBufferTextureSlot(font->GetTexture()->GetTextureID());
+            page = ~0u;
         }
     }
 }
 
-glm::ivec2 Renderer::CalculateTextSize(std::shared_ptr<Font> font, const std::string &text)
+void Renderer::RenderText(const glm::ivec2 &position, TextConsole &console, const glm::vec4 &color)
+{
+    Font *font = console.Update();
+    if(!font) return;
+
+    UseBatchShader(font->GetRendering() == Font::Rendering::DistanceField ? BatchShader::DistanceFieldText : BatchShader::BitmapText);
+
+    // Only lines that intersect the view are decoded, however long the log is.
+    // Lines cut by the top or bottom edge are drawn whole.
+    size_t first, last;
+    console.GetVisibleLines(first, last);
+    const float scale = console.GetLayoutSize() / font->GetFontSize();
+    for(size_t line = first; line < last; line++)
+    {
+        const TextConsole::Line text = console.GetLine(line);
+        const float top = position.y + line * console.GetLineHeight() - console.GetScroll();
+        const glm::vec2 pen((float)position.x, GetGameSize().y - top - console.GetLayoutSize());
+        RenderGlyphs(*font, scale, pen, font->Shape(std::string_view(*text.text).substr(text.begin, text.end - text.begin)), color);
+    }
+}
+
+glm::ivec2 Renderer::CalculateTextSize(Font &font, float size, std::string_view text)
+{
+    // The text ends where its last glyph bitmap does, not at the last advance.
+    const float scale = size / font.GetFontSize();
+    return glm::ivec2((int)ceilf(font.Shape(text).width * scale), (int)size);
+}
+
+glm::ivec2 Renderer::CalculateTextSize(FontHandle font, float size, std::string_view text)
+{
+    Font *pFont = ResourceManager::Get().GetFont(font);
+    if(!pFont) return glm::ivec2(0);
+    return CalculateTextSize(*pFont, size, text);
+}
+
+glm::ivec2 Renderer::CalculateTextSize(FontHandle font, std::string_view text)
 {
-    unsigned int x_size = 0;
-    for(int i = 0; i < text.length() - 1; i++)
+    Font *pFont = ResourceManager::Get().GetFont(font);
+    if(!pFont) return glm::ivec2(0);
+    return CalculateTextSize(*pFont, text);
+}
+
+void Renderer::SetTextEffects(const TextEffects &effects)
+{
+    if(m_BatchShader == BatchShader::DistanceFieldText)
+        DrawQuadBuffer();
+    m_TextEffects = effects;
+}
+
+void Renderer::UseBatchShader(BatchShader shader, bool premultiplied)
+{
+    if(shader == m_BatchShader && premultiplied == m_PremultipliedBatch) return;
+    DrawQuadBuffer();
+    m_BatchShader = shader;
+    if(premultiplied != m_PremultipliedBatch)
     {
-        const Font::FontCharacter &character = font->GetCharacter((unsigned char)text.at(i));
-        x_size += character.advance >> 6;
+        glBlendFunc(premultiplied ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_PremultipliedBatch = premultiplied;
     }
-    x_size += font->GetCharacter((unsigned int)text.at(text.length() - 1)).size.x;
-    return glm::ivec2(x_size, font->GetFontSize());
 }
 
 void Renderer::RenderEnd()
 {
     DrawQuadBuffer();
+    Font::AdvanceFrame();
     //SDL_Log("Draw calls: %d\n", m_iDrawCalls);
     m_iDrawCalls = 0;
     
+    FramePacer::Get().BeforeSwap();
     SDL_GL_SwapWindow(m_pWindow);
+    FramePacer::Get().AfterSwap();
 
+    // Everything the frame allocated in its arena goes with it.
+    FrameArena::Get().EndFrame();
 }
 
 void Renderer::CreateQuadBuffer(int max_count)
@@ -259,10 +431,30 @@ void Renderer::DrawQuadBuffer()
 
     glm::mat4 projection = glm::ortho(0.0f, m_GameSize.x, 0.0f, m_GameSize.y, -1.0f, 1.0f);
 
-    m_2DShader->Bind();
-    m_2DShader->SetMat4("u_MVP", projection);
-    m_2DShader->SetFloat("u_Aspect", (float)width / (float)height);
-    m_2DShader->SetFloat("u_TargetAspect", m_GameSize.x / m_GameSize.y);
+    const bool text = m_BatchShader != BatchShader::Sprite;
+    Shader *shader = ResourceManager::Get().GetShader(text ? m_TextShader : m_2DShader);
+    if(!shader)
+    {
+        // Init or LoadShader has already logged why.
+        m_QuadCount = 0;
+        m_TextureSlots.fill(~0u);
+        return;
+    }
+    unsigned int &revision = text ? m_TextShaderRevision : m_2DShaderRevision;
+    shader->Bind();
+    if(shader->GetRevision() != revision)
+        BindTextureUnits(*shader, revision);
+    shader->SetMat4("u_MVP", projection);
+    shader->SetFloat("u_Aspect", (float)width / (float)height);
+    shader->SetFloat("u_TargetAspect", m_GameSize.x / m_GameSize.y);
+    if(text)
+    {
+        shader->SetInt("u_DistanceField", m_BatchShader == BatchShader::DistanceFieldText);
+        shader->SetVec4("u_OutlineColor", m_TextEffects.outlineColor);
+        shader->SetFloat("u_OutlineWidth", m_TextEffects.outlineWidth);
+        shader->SetVec4("u_ShadowColor", m_TextEffects.shadowColor);
+        shader->SetVec2("u_ShadowOffset", m_TextEffects.shadowOffset);
+    }
 
     for(int i = 0; i < 32; i++)
     {
@@ -283,6 +475,13 @@ void Renderer::DrawQuadBuffer()
     m_iDrawCalls++;
 }
 
+void Renderer::BindTextureUnits(Shader &shader, unsigned int &revision)
+{
+    int textures[MAX_TEXTURE_IMAGE_UNITS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    shader.SetIntArray("u_Textures", MAX_TEXTURE_IMAGE_UNITS, textures);
+    revision = shader.GetRevision();
+}
+
 int Renderer::GetBufferTextureSlot(unsigned int textureID)
 {
     int slot = -1;
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <array>
+#include <string_view>
 
 #include <glm/vec4.hpp>
 #include <glm/vec2.hpp>
@@ -12,18 +13,29 @@
 #include "Shader.hpp"
 #include "Texture.hpp"
 #include "Font.hpp"
+#include "../Resource/ResourceHandle.hpp"
 
 #define MAX_QUADS 1024
 #define MAX_TEXTURE_IMAGE_UNITS 16
 
 class Transform2D;
+class TextLayout;
+class TextConsole;
 
 class Renderer {
     SINGLETON(Renderer);
 private:
     SDL_Window *m_pWindow;
     SDL_GLContext m_OpenGLContext;
-    std::unique_ptr<Shader> m_2DShader;
+    ShaderHandle m_2DShader;
+    unsigned int m_2DShaderRevision;
+    ShaderHandle m_TextShader;
+    unsigned int m_TextShaderRevision;
+    // Font atlases are single channel and need the text shader, so switching
+    // between sprites and either kind of text flushes the quad buffer.
+    enum class BatchShader { Sprite, BitmapText, DistanceFieldText } m_BatchShader;
+    // Premultiplied sprites blend with GL_ONE, so they batch apart from everything else.
+    bool m_PremultipliedBatch;
     unsigned int m_QuadBufferVetexArrayObject,
                  m_QuadBufferVertexBuffer,
                  m_QuadBufferIndexBuffer;
@@ -48,18 +60,53 @@ public:
     {
         Left, Center, Right
     };
+    // Applied to distance-field text only. Widths and offsets are in screen
+    // pixels, and are limited by the font's distance-field spread.
+    struct TextEffects
+    {
+        glm::vec4 outlineColor = glm::vec4(0.0f);
+        float outlineWidth = 0.0f;
+        glm::vec4 shadowColor = glm::vec4(0.0f);
+        glm::vec2 shadowOffset = glm::vec2(0.0f);
+    };
+private:
+    TextEffects m_TextEffects;
 public:
+    // Queues the renderer's assets for background loading; call before Init.
+    void Preload();
     void Init(SDL_Window *pWindow);
     void RenderBegin();
-    void RenderTexturedQuad(std::shared_ptr<Texture> texture, const glm::mat4 &transform);
+    void RenderTexturedQuad(const Texture &texture, const glm::mat4 &transform);
+    void RenderTexturedQuad(TextureHandle texture, const glm::mat4 &transform);
+    void RenderTexturedQuad(SubTextureHandle texture, const glm::mat4 &transform);
+    void RenderTexturedQuad(const std::shared_ptr<Texture> &texture, const glm::mat4 &transform) { RenderTexturedQuad(*texture, transform); }
     void RenderQuad(const glm::mat4 &transform, const glm::vec4 &color = glm::vec4(1.0f));
-    void RenderText(const glm::ivec2 &position, std::shared_ptr<Font> font, const std::string &text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top);
-    glm::ivec2 CalculateTextSize(std::shared_ptr<Font> font, const std::string &text);
+    // Applies to the RenderText calls that follow.
+    void SetTextEffects(const TextEffects &effects);
+    // size scales the font; distance-field fonts stay sharp at any size.
+    void RenderText(const glm::ivec2 &position, Font &font, float size, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top);
+    void RenderText(const glm::ivec2 &position, FontHandle font, float size, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top);
+    void RenderText(const glm::ivec2 &position, Font &font, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top);
+    void RenderText(const glm::ivec2 &position, FontHandle font, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top);
+    void RenderText(const glm::ivec2 &position, const std::shared_ptr<Font> &font, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), TextHAlign halign = TextHAlign::Left, TextVAlign valign = TextVAlign::Top) { RenderText(position, *font, text, color, halign, valign); }
+    // Draws cached quads; cheaper than the string overloads for text that rarely changes.
+    void RenderText(const glm::ivec2 &position, TextLayout &layout, const glm::vec4 &color = glm::vec4(1.0f));
+    // Draws the visible part of a console, with the top left of its view at position.
+    void RenderText(const glm::ivec2 &position, TextConsole &console, const glm::vec4 &color = glm::vec4(1.0f));
+    glm::ivec2 CalculateTextSize(Font &font, float size, std::string_view text);
+    glm::ivec2 CalculateTextSize(Font &font, std::string_view text) { return CalculateTextSize(font, (float)font.GetFontSize(), text); }
+    glm::ivec2 CalculateTextSize(FontHandle font, float size, std::string_view text);
+    glm::ivec2 CalculateTextSize(FontHandle font, std::string_view text);
+    glm::ivec2 CalculateTextSize(const std::shared_ptr<Font> &font, std::string_view text) { return CalculateTextSize(*font, text); }
     void RenderEnd();
     void OnResize(int width, int height);
     inline const glm::vec2 &GetGameSize() { return m_GameSize; }
 private:
     void CreateQuadBuffer(int max_count);
+    void BindTextureUnits(Shader &shader, unsigned int &revision);
+    void UseBatchShader(BatchShader shader, bool premultiplied = false);
     void DrawQuadBuffer();
+    // Queues one quad per glyph along a baseline starting at pen.
+    void RenderGlyphs(Font &font, float scale, const glm::vec2 &pen, const Font::ShapedText &text, const glm::vec4 &color);
     int GetBufferTextureSlot(unsigned int textureID);
 };
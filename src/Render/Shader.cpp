@@ -26,9 +26,19 @@ Shader::Shader(const std::string &vertex_path, const std::string &fragment_path)
     };
 
     std::string vertex_source = read_file(vertex_path);
-    const char *vertex_cstr = vertex_source.c_str();
-    const int vertex_length = (int)vertex_source.length();
+    std::string fragment_source = read_file(fragment_path);
+
+    m_ProgramID = Compile(vertex_source.c_str(), (int)vertex_source.length(), fragment_source.c_str(), (int)fragment_source.length(), vertex_path, fragment_path);
+}
+
+Shader::Shader(const char *vertex_source, int vertex_length, const char *fragment_source, int fragment_length, const std::string &debug_name)
+    : m_ProgramID(~0u)
+{
+    m_ProgramID = Compile(vertex_source, vertex_length, fragment_source, fragment_length, debug_name, debug_name);
+}
 
+unsigned int Shader::Compile(const char *vertex_cstr, int vertex_length, const char *fragment_cstr, int fragment_length, const std::string &vertex_path, const std::string &fragment_path)
+{
     unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex_shader, 1, &vertex_cstr, &vertex_length);
     glCompileShader(vertex_shader);
@@ -43,13 +53,9 @@ Shader::Shader(const std::string &vertex_path, const std::string &fragment_path)
         SDL_Log("Vertex Shader (%s) failed to compile.\n%s\n", vertex_path.c_str(), message);
 
         glDeleteShader(vertex_shader);
-        return;
+        return ~0u;
     }
 
-    std::string fragment_source = read_file(fragment_path);
-    const char *fragment_cstr = fragment_source.c_str();
-    const int fragment_length = (int)fragment_source.length();
-    
     unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragment_shader, 1, &fragment_cstr, &fragment_length);
     glCompileShader(fragment_shader);
@@ -64,7 +70,7 @@ Shader::Shader(const std::string &vertex_path, const std::string &fragment_path)
 
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
-        return;
+        return ~0u;
     }
 
     unsigned int program = glCreateProgram();
@@ -86,7 +92,25 @@ Shader::Shader(const std::string &vertex_path, const std::string &fragment_path)
     glDetachShader(program, fragment_shader);
     glDeleteShader(fragment_shader);
     
+    return program;
+}
+
+bool Shader::Reload(const char *vertex_source, int vertex_length, const char *fragment_source, int fragment_length, const std::string &debug_name)
+{
+    unsigned int program = Compile(vertex_source, vertex_length, fragment_source, fragment_length, debug_name, debug_name);
+    // Keep running the old program if the edit doesn't compile.
+    if(program == ~0u)
+        return false;
+
+    if(s_CurrentlyBoundProgram == m_ProgramID)
+        s_CurrentlyBoundProgram = UINT32_MAX;
+    if(m_ProgramID != ~0u)
+        glDeleteProgram(m_ProgramID);
+
     m_ProgramID = program;
+    m_Uniforms.clear();
+    m_Revision++;
+    return true;
 }
 
 Shader::~Shader()
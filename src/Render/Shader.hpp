@@ -9,13 +9,18 @@ class Shader
 {
 private:
     unsigned int m_ProgramID;
+    unsigned int m_Revision = 0;
     std::unordered_map<std::string, unsigned int> m_Uniforms;
     static unsigned int s_CurrentlyBoundProgram;
 public:
     Shader(const std::string &path_vertex, const std::string &path_fragment);
+    Shader(const char *vertex_source, int vertex_length, const char *fragment_source, int fragment_length, const std::string &debug_name = "");
     ~Shader();
     void Bind() const;
     bool IsValid() const;
+    // Recompiles in place. Uniform values are lost, so users re-apply them when the revision changes.
+    bool Reload(const char *vertex_source, int vertex_length, const char *fragment_source, int fragment_length, const std::string &debug_name = "");
+    inline unsigned int GetRevision() const { return m_Revision; }
 
     void SetFloat(const std::string &uniform, float v);
     void SetVec2(const std::string &uniform, const glm::vec2 &vec);
@@ -60,5 +65,6 @@ public:
     void SetUVec3Array(const std::string &uniform, int count, glm::uvec3 *vec);
     void SetUVec4Array(const std::string &uniform, int count, glm::uvec4 *vec);
 private:
+    static unsigned int Compile(const char *vertex_source, int vertex_length, const char *fragment_source, int fragment_length, const std::string &vertex_name, const std::string &fragment_name);
     int GetUniformLoc(const std::string &uniform);
 };
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "TextConsole.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Font.hpp"
+#include "Utf8.hpp"
+#include "../Resource/ResourceManager.hpp"
+
+void TextConsole::LineIndex::Clear()
+{
+    m_Tree.clear();
+    m_Counts.clear();
+}
+
+void TextConsole::LineIndex::Append(uint32_t count)
+{
+    // Node i covers the lowbit(i) paragraphs ending at i, counting from 1.
+    const size_t i = m_Counts.size() + 1;
+    m_Counts.push_back(count);
+    m_Tree.push_back(count + Prefix(i - 1) - Prefix(i - (i & (~i + 1))));
+}
+
+void TextConsole::LineIndex::Set(size_t paragraph, uint32_t count)
+{
+    // Unsigned wrap-around makes a negative delta come out right.
+    const size_t delta = (size_t)count - m_Counts[paragraph];
+    m_Counts[paragraph] = count;
+    for(size_t i = paragraph + 1; i <= m_Tree.size(); i += i & (~i + 1))
+        m_Tree[i - 1] += delta;
+}
+
+size_t TextConsole::LineIndex::Prefix(size_t paragraph) const
+{
+    size_t sum = 0;
+    for(size_t i = paragraph; i > 0; i -= i & (~i + 1))
+        sum += m_Tree[i - 1];
+    return sum;
+}
+
+size_t TextConsole::LineIndex::Find(size_t line) const
+{
+    // Walk down the implicit tree, skipping every block that ends at or before the line.
+    size_t step = 1;
+    while(step * 2 <= m_Tree.size())
+        step *= 2;
+
+    size_t position = 0;
+    for(; step; step /= 2)
+    {
+        if(position + step <= m_Tree.size() && m_Tree[position + step - 1] <= line)
+        {
+            position += step;
+            line -= m_Tree[position - 1];
+        }
+    }
+    return position;
+}
+
+TextConsole::TextConsole(FontHandle font, float size, const glm::vec2 &view_size)
+    : m_Font(font), m_Size(size), m_ViewSize(view_size)
+{
+}
+
+void TextConsole::SetFont(FontHandle font, float size)
+{
+    if(font == m_Font && size == m_Size) return;
+    m_Font = font;
+    m_Size = size;
+    m_AllDirty = true;
+}
+
+void TextConsole::SetViewSize(const glm::vec2 &view_size)
+{
+    if(view_size == m_ViewSize) return;
+    // Only the width affects wrapping.
+    if(view_size.x != m_ViewSize.x)
+        m_AllDirty = true;
+    m_ViewSize = view_size;
+}
+
+size_t TextConsole::AddParagraph(const std::string &text)
+{
+    m_Paragraphs.push_back(Paragraph{ text, {} });
+    m_Lines.Append(0);
+    m_DirtyParagraphs.push_back(m_Paragraphs.size() - 1);
+    return m_Paragraphs.size() - 1;
+}
+
+void TextConsole::SetParagraph(size_t paragraph, const std::string &text)
+{
+    Paragraph &edited = m_Paragraphs[paragraph];
+    if(edited.text == text) return;
+    edited.text = text;
+    m_DirtyParagraphs.push_back(paragraph);
+}
+
+void TextConsole::Clear()
+{
+    m_Paragraphs.clear();
+    m_Lines.Clear();
+    m_DirtyParagraphs.clear();
+    m_Scroll = 0.0f;
+    m_FollowTail = true;
+}
+
+void TextConsole::SetScroll(float scroll)
+{
+    m_Scroll = std::max(0.0f, std::min(scroll, GetMaxScroll()));
+    m_FollowTail = m_Scroll >= GetMaxScroll();
+}
+
+void TextConsole::ScrollToBottom()
+{
+    m_Scroll = GetMaxScroll();
+    m_FollowTail = true;
+}
+
+float TextConsole::GetMaxScroll() const
+{
+    return std::max(0.0f, GetContentHeight() - m_ViewSize.y);
+}
+
+Font *TextConsole::Update()
+{
+    Font *font = ResourceManager::Get().GetFont(m_Font);
+    if(!font) return nullptr;
+
+    // Wrapping depends on glyph metrics only, so atlas evictions do not invalidate it.
+    const float size = m_Size > 0.0f ? m_Size : (float)font->GetFontSize();
+    if(font != m_LayoutFont || size != m_LayoutSize)
+    {
+        m_LayoutFont = font;
+        m_LayoutSize = size;
+        m_LineHeight = font->GetLineHeight() * size / font->GetFontSize();
+        m_AllDirty = true;
+    }
+
+    if(m_AllDirty)
+    {
+        m_Lines.Clear();
+        for(Paragraph &paragraph : m_Paragraphs)
+        {
+            Wrap(*font, paragraph);
+            m_Lines.Append((uint32_t)paragraph.lineStarts.size());
+        }
+        m_AllDirty = false;
+    }
+    else
+    {
+        for(size_t paragraph : m_DirtyParagraphs)
+        {
+            Wrap(*font, m_Paragraphs[paragraph]);
+            m_Lines.Set(paragraph, (uint32_t)m_Paragraphs[paragraph].lineStarts.size());
+        }
+    }
+    m_DirtyParagraphs.clear();
+
+    if(m_FollowTail)
+        m_Scroll = GetMaxScroll();
+    else
+        m_Scroll = std::min(m_Scroll, GetMaxScroll());
+    return font;
+}
+
+void TextConsole::Wrap(Font &font, Paragraph &paragraph) const
+{
+    const float scale = m_LayoutSize / font.GetFontSize();
+    const float padding = font.GetGlyphPadding() * scale;
+    const float wrap_width = m_ViewSize.x;
+    const std::string &text = paragraph.text;
+
+    paragraph.lineStarts.assign(1, 0);
+    float pen = 0.0f;
+    // Where the current word starts, so a word that overflows moves down whole.
+    uint32_t word_start = 0;
+    float word_pen = 0.0f;
+    uint32_t previous = 0;
+
+    for(auto it = text.cbegin(); it != text.cend();)
+    {
+        const uint32_t start = (uint32_t)(it - text.cbegin());
+        const uint32_t codepoint = DecodeUtf8(it, text.cend());
+        const uint32_t next = (uint32_t)(it - text.cbegin());
+        if(codepoint == '\n')
+        {
+            previous = 0;
+            paragraph.lineStarts.push_back(next);
+            pen = word_pen = 0.0f;
+            word_start = next;
+            continue;
+        }
+
+        // Lines are drawn kerned, so they are measured that way too.
+        if(previous)
+            pen += font.GetKerning(previous, codepoint) * scale;
+        previous = codepoint;
+
+        const Font::FontCharacter &character = font.GetCharacter(codepoint);
+        if(codepoint == ' ')
+        {
+            pen += character.advance * scale;
+            word_start = next;
+            word_pen = pen;
+            continue;
+        }
+
+        const float right = pen + (character.bearing.x + character.size.x) * scale - padding;
+        if(wrap_width > 0.0f && right > wrap_width)
+        {
+            if(word_pen > 0.0f)
+            {
+                paragraph.lineStarts.push_back(word_start);
+                pen -= word_pen;
+                word_pen = 0.0f;
+            }
+            else if(start > paragraph.lineStarts.back())
+            {
+                // A single word wider than the view is broken between characters.
+                paragraph.lineStarts.push_back(start);
+                pen = 0.0f;
+                word_start = start;
+            }
+        }
+        pen += character.advance * scale;
+    }
+}
+
+void TextConsole::GetVisibleLines(size_t &first, size_t &last) const
+{
+    first = last = 0;
+    if(m_LineHeight <= 0.0f) return;
+    const size_t count = GetLineCount();
+    first = std::min(count, (size_t)(m_Scroll / m_LineHeight));
+    last = std::min(count, (size_t)ceilf((m_Scroll + m_ViewSize.y) / m_LineHeight));
+}
+
+TextConsole::Line TextConsole::GetLine(size_t line) const
+{
+    const size_t paragraph_index = m_Lines.Find(line);
+    const Paragraph &paragraph = m_Paragraphs[paragraph_index];
+    const size_t index = line - m_Lines.Prefix(paragraph_index);
+
+    Line result;
+    result.text = &paragraph.text;
+    result.begin = paragraph.lineStarts[index];
+    result.end = index + 1 < paragraph.lineStarts.size() ? paragraph.lineStarts[index + 1] : paragraph.text.size();
+    // Leave the newline that ended the line out of it.
+    if(result.end > result.begin && paragraph.text[result.end - 1] == '\n')
+        result.end--;
+    return result;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+
+#include "../Resource/ResourceHandle.hpp"
+
+class Font;
+
+// A scrolling block of word-wrapped text for logs and chat, meant to hold
+// hundreds of thousands of lines. Each added entry is a paragraph that is
+// wrapped once and only wrapped again when it is edited or the font or wrap
+// width changes. A prefix sum of wrapped line counts finds the paragraph at
+// any scroll offset in O(log n), and only the visible lines are drawn.
+class TextConsole
+{
+public:
+    // A wrapped line as a byte range of its paragraph's text.
+    struct Line
+    {
+        const std::string *text;
+        size_t begin, end;
+    };
+private:
+    struct Paragraph
+    {
+        std::string text;
+        // Byte offset where each wrapped line starts. Empty until wrapped.
+        std::vector<uint32_t> lineStarts;
+    };
+    // Fenwick tree over the wrapped line count of every paragraph.
+    class LineIndex
+    {
+    private:
+        std::vector<size_t> m_Tree;
+        std::vector<uint32_t> m_Counts;
+    public:
+        void Clear();
+        void Append(uint32_t count);
+        void Set(size_t paragraph, uint32_t count);
+        inline size_t GetSize() const { return m_Counts.size(); }
+        inline uint32_t GetCount(size_t paragraph) const { return m_Counts[paragraph]; }
+        // Lines in paragraphs [0, paragraph).
+        size_t Prefix(size_t paragraph) const;
+        // The paragraph holding the given line; GetSize() if it is past the end.
+        size_t Find(size_t line) const;
+    };
+
+    FontHandle m_Font;
+    float m_Size = 0.0f;
+    glm::vec2 m_ViewSize = glm::vec2(0.0f);
+    float m_Scroll = 0.0f;
+    bool m_FollowTail = true;
+
+    std::vector<Paragraph> m_Paragraphs;
+    LineIndex m_Lines;
+    std::vector<size_t> m_DirtyParagraphs;
+    bool m_AllDirty = false;
+    const Font *m_LayoutFont = nullptr;
+    float m_LayoutSize = 0.0f;
+    float m_LineHeight = 0.0f;
+public:
+    TextConsole() = default;
+    // size 0 uses the font's own size. view_size is the visible area in pixels;
+    // its width is also the wrap width.
+    TextConsole(FontHandle font, float size, const glm::vec2 &view_size);
+
+    void SetFont(FontHandle font, float size = 0.0f);
+    void SetViewSize(const glm::vec2 &view_size);
+
+    // Appends a paragraph and returns its index. Embedded newlines break lines
+    // but stay in the same paragraph.
+    size_t AddParagraph(const std::string &text);
+    void SetParagraph(size_t paragraph, const std::string &text);
+    void Clear();
+    inline size_t GetParagraphCount() const { return m_Paragraphs.size(); }
+    inline const std::string &GetParagraph(size_t paragraph) const { return m_Paragraphs[paragraph].text; }
+
+    // Pixels scrolled down from the first line. While scrolled to the bottom
+    // the view keeps following new paragraphs.
+    void SetScroll(float scroll);
+    void ScrollBy(float delta) { SetScroll(m_Scroll + delta); }
+    void ScrollToBottom();
+    inline float GetScroll() const { return m_Scroll; }
+
+    // Wraps whatever changed since the last call and returns the font to draw
+    // with, or nullptr if it is gone. The queries below are valid after this.
+    Font *Update();
+    inline float GetLineHeight() const { return m_LineHeight; }
+    // The size text is drawn at, resolved against the font.
+    inline float GetLayoutSize() const { return m_LayoutSize; }
+    inline size_t GetLineCount() const { return m_Lines.Prefix(m_Lines.GetSize()); }
+    inline float GetContentHeight() const { return GetLineCount() * m_LineHeight; }
+    // First and one-past-last wrapped lines that intersect the view.
+    void GetVisibleLines(size_t &first, size_t &last) const;
+    // Finds a wrapped line; lines are numbered across all paragraphs.
+    Line GetLine(size_t line) const;
+private:
+    void Wrap(Font &font, Paragraph &paragraph) const;
+    float GetMaxScroll() const;
+};
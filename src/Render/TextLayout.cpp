@@ -0,0 +1,179 @@
+#include "TextLayout.hpp"
+
+#include <algorithm>
+
+#include "Utf8.hpp"
+#include "../Resource/ResourceManager.hpp"
+
+TextLayout::TextLayout(FontHandle font, float size, const std::string &text, float wrap_width)
+    : m_Font(font), m_Size(size), m_Text(text), m_WrapWidth(wrap_width)
+{
+}
+
+void TextLayout::SetFont(FontHandle font, float size)
+{
+    if(font == m_Font && size == m_Size) return;
+    m_Font = font;
+    m_Size = size;
+    m_Dirty = true;
+}
+
+void TextLayout::SetText(std::string_view text)
+{
+    if(text == m_Text) return;
+    m_Text.assign(text.data(), text.size());
+    m_Dirty = true;
+}
+
+void TextLayout::SetWrapWidth(float wrap_width)
+{
+    if(wrap_width == m_WrapWidth) return;
+    m_WrapWidth = wrap_width;
+    m_Dirty = true;
+}
+
+void TextLayout::SetAlignment(Renderer::TextHAlign halign, Renderer::TextVAlign valign)
+{
+    if(halign == m_HAlign && valign == m_VAlign) return;
+    m_HAlign = halign;
+    m_VAlign = valign;
+    m_Dirty = true;
+}
+
+Font *TextLayout::Update()
+{
+    Font *font = ResourceManager::Get().GetFont(m_Font);
+    if(!font) return nullptr;
+
+    if(m_Dirty || font != m_LayoutFont || font->GetGeneration() != m_LayoutGeneration)
+    {
+        m_Dirty = !Layout(*font);
+        m_LayoutFont = font;
+        m_LayoutGeneration = font->GetGeneration();
+    }
+    return font;
+}
+
+bool TextLayout::Layout(Font &font)
+{
+    const float size = m_Size > 0.0f ? m_Size : (float)font.GetFontSize();
+    const float scale = size / font.GetFontSize();
+    const float line_height = font.GetLineHeight() * scale;
+    const float padding = font.GetGlyphPadding() * scale;
+
+    m_Glyphs.clear();
+    m_Pages.clear();
+    m_Lines.assign(1, 0);
+
+    float pen = 0.0f, baseline = 0.0f;
+    // Where the current word starts, so a word that overflows moves down whole.
+    size_t word_first = 0;
+    float word_pen = 0.0f;
+    uint32_t previous = 0;
+    bool complete = true;
+
+    for(auto it = m_Text.cbegin(); it != m_Text.cend();)
+    {
+        const uint32_t codepoint = DecodeUtf8(it, m_Text.cend());
+        if(codepoint == '\n')
+        {
+            previous = 0;
+            m_Lines.push_back(m_Glyphs.size());
+            pen = word_pen = 0.0f;
+            baseline -= line_height;
+            word_first = m_Glyphs.size();
+            continue;
+        }
+
+        if(previous)
+            pen += font.GetKerning(previous, codepoint) * scale;
+        previous = codepoint;
+
+        const Font::FontCharacter &character = font.GetCharacter(codepoint);
+        if(font.IsUnplaced(character))
+            complete = false;
+        if(codepoint == ' ')
+        {
+            pen += character.advance * scale;
+            word_first = m_Glyphs.size();
+            word_pen = pen;
+            continue;
+        }
+
+        const float right = pen + character.bearing.x * scale + character.size.x * scale - padding;
+        if(m_WrapWidth > 0.0f && right > m_WrapWidth && word_pen > 0.0f)
+        {
+            for(size_t i = word_first; i < m_Glyphs.size(); i++)
+            {
+                m_Glyphs[i].bottomLeft += glm::vec2(-word_pen, -line_height);
+                m_Glyphs[i].topRight += glm::vec2(-word_pen, -line_height);
+            }
+            m_Lines.push_back(word_first);
+            pen -= word_pen;
+            word_pen = 0.0f;
+            baseline -= line_height;
+        }
+
+        if(character.size.x && character.size.y)
+        {
+            Glyph glyph;
+            glyph.bottomLeft = glm::vec2(pen + character.bearing.x * scale, baseline - (character.size.y - character.bearing.y) * scale);
+            glyph.topRight = glyph.bottomLeft + glm::vec2(character.size) * scale;
+            // Atlas rows run top to bottom, so the UVs flip vertically.
+            const glm::vec4 uv = font.GetUV(character);
+            glyph.bottomLeftUV = glm::vec2(uv.x, uv.w);
+            glyph.topRightUV = glm::vec2(uv.z, uv.y);
+            glyph.page = character.page;
+            m_Glyphs.push_back(glyph);
+            if(std::find(m_Pages.begin(), m_Pages.end(), glyph.page) == m_Pages.end())
+                m_Pages.push_back(glyph.page);
+        }
+        pen += character.advance * scale;
+    }
+    m_Lines.push_back(m_Glyphs.size());
+
+    const size_t line_count = m_Lines.size() - 1;
+    float y_offset = 0.0f;
+    switch(m_VAlign)
+    {
+        case Renderer::TextVAlign::Top:
+            y_offset = -size;
+            break;
+        case Renderer::TextVAlign::Center:
+            y_offset = (-size + (line_count - 1) * line_height) / 2.0f;
+            break;
+        case Renderer::TextVAlign::Bottom:
+            y_offset = (line_count - 1) * line_height;
+            break;
+    }
+
+    m_Bounds = glm::vec2(0.0f, line_count * line_height);
+    for(size_t line = 0; line < line_count; line++)
+    {
+        float width = 0.0f;
+        for(size_t i = m_Lines[line]; i < m_Lines[line + 1]; i++)
+            width = std::max(width, m_Glyphs[i].topRight.x - padding);
+        m_Bounds.x = std::max(m_Bounds.x, width);
+
+        float x_offset = 0.0f;
+        switch(m_HAlign)
+        {
+            case Renderer::TextHAlign::Left:
+                x_offset = 0.0f;
+                break;
+            case Renderer::TextHAlign::Center:
+                x_offset = -width / 2.0f;
+                break;
+            case Renderer::TextHAlign::Right:
+                x_offset = -width;
+                break;
+        }
+
+        for(size_t i = m_Lines[line]; i < m_Lines[line + 1]; i++)
+        {
+            m_Glyphs[i].bottomLeft += glm::vec2(x_offset, y_offset);
+            m_Glyphs[i].topRight += glm::vec2(x_offset, y_offset);
+        }
+    }
+    return complete;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "Renderer.hpp"
+#include "../Resource/ResourceHandle.hpp"
+
+// A string that is shaped and measured once and then drawn from cached quads.
+// It lays itself out again only when its text, font, size, wrap width or
+// alignment changes, when the font evicts glyphs it was using, or when a
+// glyph found no room in the atlas the last time.
+class TextLayout
+{
+public:
+    struct Glyph
+    {
+        glm::vec2 bottomLeft, topRight;
+        glm::vec2 bottomLeftUV, topRightUV;
+        unsigned int page;
+    };
+private:
+    FontHandle m_Font;
+    float m_Size = 0.0f;
+    std::string m_Text;
+    float m_WrapWidth = 0.0f;
+    Renderer::TextHAlign m_HAlign = Renderer::TextHAlign::Left;
+    Renderer::TextVAlign m_VAlign = Renderer::TextVAlign::Top;
+
+    bool m_Dirty = true;
+    const Font *m_LayoutFont = nullptr;
+    unsigned int m_LayoutGeneration = 0;
+    std::vector<Glyph> m_Glyphs;
+    std::vector<unsigned int> m_Pages;
+    // Index of the first glyph on each line, kept so relayouts reuse its capacity.
+    std::vector<size_t> m_Lines;
+    glm::vec2 m_Bounds = glm::vec2(0.0f);
+public:
+    TextLayout() = default;
+    // size 0 uses the font's own size. wrap_width 0 disables word wrapping.
+    TextLayout(FontHandle font, float size, const std::string &text, float wrap_width = 0.0f);
+
+    void SetFont(FontHandle font, float size = 0.0f);
+    // Does nothing if the text is unchanged, so it is cheap to call every frame.
+    void SetText(std::string_view text);
+    void SetWrapWidth(float wrap_width);
+    void SetAlignment(Renderer::TextHAlign halign, Renderer::TextVAlign valign);
+
+    inline FontHandle GetFont() const { return m_Font; }
+    inline const std::string &GetText() const { return m_Text; }
+
+    // Lays the text out again if anything it depends on changed. Returns the
+    // font to draw with, or nullptr if it is gone.
+    Font *Update();
+    // Quads relative to the anchor point, y up.
+    inline const std::vector<Glyph> &GetGlyphs() const { return m_Glyphs; }
+    // Atlas pages the quads sample from.
+    inline const std::vector<unsigned int> &GetPages() const { return m_Pages; }
+    // Width of the widest line and height of all lines, valid after Update.
+    inline const glm::vec2 &GetBounds() const { return m_Bounds; }
+private:
+    // Returns false if a glyph found no atlas room, so the layout is redone next Update.
+    bool Layout(Font &font);
+};
@@ -1,9 +1,15 @@
 #include "Texture.hpp"
 
+#include <cstring>
+
 #include <stb/stb_image.h>
 #include <glad/glad.h>
+#include <SDL_log.h>
+
+#include "../Resource/CookedTextureFormat.hpp"
 
 Texture::Texture(const std::string &file_path)
+    : m_TextureID(~0u), m_Channels(0), m_Size(0), m_Premultiplied(false)
 {
     stbi_set_flip_vertically_on_load(1);
     int w, h, c;
@@ -14,22 +20,124 @@ Texture::Texture(const std::string &file_path)
         return;
     }
 
-    m_Size = glm::vec2(w, h);
+    Upload(data, w, h, c);
+
+    stbi_image_free(data);
+}
+
+Texture::Texture(const unsigned char *file_data, int file_size, const std::string &debug_name)
+    : m_TextureID(~0u), m_Channels(0), m_Size(0), m_Premultiplied(false)
+{
+    if(IsCooked(file_data, file_size))
+    {
+        UploadCooked(file_data, file_size, debug_name);
+        return;
+    }
+
+    Image image;
+    if(Decode(file_data, file_size, image, debug_name))
+        Upload(image.pixels.get(), image.width, image.height, image.channels);
+}
+
+Texture::Texture(const Image &image)
+    : m_TextureID(~0u), m_Channels(0), m_Size(0), m_Premultiplied(false)
+{
+    if(image.pixels)
+        Upload(image.pixels.get(), image.width, image.height, image.channels);
+}
+
+void Texture::Image::Deleter::operator()(unsigned char *pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+bool Texture::Decode(const unsigned char *file_data, int file_size, Image &image, const std::string &debug_name)
+{
+    stbi_set_flip_vertically_on_load_thread(1);
+    unsigned char *data = stbi_load_from_memory(file_data, file_size, &image.width, &image.height, &image.channels, 4);
+    if(!data)
+    {
+        fprintf(stderr, "Cannot load image file %s\nSTB Reason: %s\n", debug_name.c_str(), stbi_failure_reason());
+        return false;
+    }
+    image.pixels.reset(data);
+    return true;
+}
+
+void Texture::Upload(const unsigned char *pixels, int w, int h, int c)
+{
+    m_Size = glm::ivec2(w, h);
     m_Channels = c;
+    m_Premultiplied = false;
 
-    glGenTextures(1, &m_TextureID);
+    // Reuse the existing texture object when reloading so anything holding its ID stays valid.
+    if(m_TextureID == ~0u)
+        glGenTextures(1, &m_TextureID);
     glBindTexture(GL_TEXTURE_2D, m_TextureID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
     
     glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-    stbi_image_free(data);
+void Texture::Reload(const Image &image)
+{
+    if(image.pixels)
+        Upload(image.pixels.get(), image.width, image.height, image.channels);
+}
+
+bool Texture::IsCooked(const unsigned char *file_data, int file_size)
+{
+    uint32_t magic;
+    if(file_size < (int)sizeof(CookedTextureHeader)) return false;
+    memcpy(&magic, file_data, sizeof(magic));
+    return magic == COOKED_TEXTURE_MAGIC;
+}
+
+void Texture::UploadCooked(const unsigned char *file_data, int file_size, const std::string &debug_name)
+{
+    const CookedTextureHeader *header = (const CookedTextureHeader *)file_data;
+    if(header->version != COOKED_TEXTURE_VERSION || !header->levelCount || header->levelCount > COOKED_TEXTURE_MAX_LEVELS)
+    {
+        SDL_Log("Cooked texture %s has an unsupported format.\n", debug_name.c_str());
+        return;
+    }
+    for(uint32_t i = 0; i < header->levelCount; i++)
+    {
+        const CookedTextureLevel &level = header->levels[i];
+        if((uint64_t)level.offset + level.size > (uint64_t)file_size || level.size < (uint64_t)level.width * level.height * 4)
+        {
+            SDL_Log("Cooked texture %s is truncated.\n", debug_name.c_str());
+            return;
+        }
+    }
+
+    m_Size = glm::ivec2(header->width, header->height);
+    m_Channels = header->channels;
+    m_Premultiplied = (header->flags & COOKEDTEXTUREFLAG_PREMULTIPLIED) != 0;
+
+    glGenTextures(1, &m_TextureID);
+    glBindTexture(GL_TEXTURE_2D, m_TextureID);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, header->levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->levelCount - 1);
+
+    for(uint32_t i = 0; i < header->levelCount; i++)
+    {
+        const CookedTextureLevel &level = header->levels[i];
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, file_data + level.offset);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture()
@@ -37,8 +145,8 @@ Texture::~Texture()
     if(m_TextureID != ~0u) glDeleteTextures(1, &m_TextureID);
 }
 
-Texture::Texture(unsigned int textureID, const glm::ivec2 &size, int channels)
-    : m_TextureID(textureID), m_Size(size), m_Channels(channels)
+Texture::Texture(unsigned int textureID, const glm::ivec2 &size, int channels, bool premultiplied)
+    : m_TextureID(textureID), m_Channels(channels), m_Size(size), m_Premultiplied(premultiplied)
 {
 
 }
@@ -50,7 +158,7 @@ void Texture::Bind(unsigned char slot) const
 }
 
 SubTexture::SubTexture(std::shared_ptr<Texture> texture, int top, int left, int bottom, int right)
-    : Texture(texture->GetTextureID(), glm::ivec2(right - left, bottom - top), texture->GetChannels()), m_ParentTexture(texture)
+    : Texture(texture->GetTextureID(), glm::ivec2(right - left, bottom - top), texture->GetChannels(), texture->IsPremultiplied()), m_ParentTexture(texture)
 {
     TextureUV uv = texture->GetUV();
     glm::ivec2 size = texture->GetSize();
@@ -11,20 +11,37 @@ private:
     unsigned int m_TextureID;
     int m_Channels;
     glm::ivec2 m_Size;
+    // Cooked with --premultiply; drawn with GL_ONE, GL_ONE_MINUS_SRC_ALPHA.
+    bool m_Premultiplied;
 protected:
-    Texture(unsigned int textureID, const glm::ivec2 &size, int channels);
+    Texture(unsigned int textureID, const glm::ivec2 &size, int channels, bool premultiplied = false);
     void InvalidateTextureID() { m_TextureID = ~0u; }
+    void Upload(const unsigned char *pixels, int width, int height, int channels);
+    void UploadCooked(const unsigned char *file_data, int file_size, const std::string &debug_name);
 public:
     struct TextureUV {
         glm::vec2 bottomLeft;
         glm::vec2 topRight;
     };
+    // Decoded RGBA pixels, flipped for OpenGL. Produced by Decode, which touches
+    // no GL state and may run on any thread.
+    struct Image {
+        struct Deleter { void operator()(unsigned char *pixels) const; };
+        std::unique_ptr<unsigned char[], Deleter> pixels;
+        int width = 0, height = 0, channels = 0;
+    };
 public:
     Texture() = delete;
     Texture(const Texture&) = delete;
     Texture(const std::string &file_path);
+    Texture(const unsigned char *file_data, int file_size, const std::string &debug_name = "");
+    Texture(const Image &image);
     virtual ~Texture();
+    static bool IsCooked(const unsigned char *file_data, int file_size);
+    static bool Decode(const unsigned char *file_data, int file_size, Image &image, const std::string &debug_name = "");
     void Bind(unsigned char slot) const;
+    // Replaces the pixels of the existing GL texture with a decoded image.
+    void Reload(const Image &image);
 
     virtual const TextureUV &GetUV() const { static TextureUV uv{glm::vec2(0.0f), glm::vec2(1.0f)}; return uv; };
 
@@ -33,6 +50,7 @@ public:
     inline int GetHeight() const { return m_Size.y; }
     inline const glm::ivec2 &GetSize() const { return m_Size; }
     inline int GetChannels() const { return m_Channels; }
+    inline bool IsPremultiplied() const { return m_Premultiplied; }
 };
 
 class SubTexture : public Texture {
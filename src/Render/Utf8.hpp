@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+static const uint32_t UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+// Decodes the code point at it and advances past it. Malformed or truncated
+// sequences decode to U+FFFD and resume at the first byte that broke them.
+template<typename Iterator>
+inline uint32_t DecodeUtf8(Iterator &it, Iterator end)
+{
+    const unsigned char lead = (unsigned char)*it++;
+    if(lead < 0x80)
+        return lead;
+
+    int length;
+    uint32_t codepoint;
+    if((lead & 0xE0) == 0xC0)      { length = 1; codepoint = lead & 0x1F; }
+    else if((lead & 0xF0) == 0xE0) { length = 2; codepoint = lead & 0x0F; }
+    else if((lead & 0xF8) == 0xF0) { length = 3; codepoint = lead & 0x07; }
+    else return UTF8_REPLACEMENT_CHARACTER;
+
+    for(int i = 0; i < length; i++)
+    {
+        if(it == end || ((unsigned char)*it & 0xC0) != 0x80)
+            return UTF8_REPLACEMENT_CHARACTER;
+        codepoint = (codepoint << 6) | ((unsigned char)*it++ & 0x3F);
+    }
+
+    // Reject overlong forms, surrogates and values past the Unicode range.
+    static const uint32_t minimum[] = { 0, 0x80, 0x800, 0x10000 };
+    if(codepoint < minimum[length] || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        return UTF8_REPLACEMENT_CHARACTER;
+    return codepoint;
+}
@@ -0,0 +1,148 @@
+#include "AssetPack.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <SDL_log.h>
+
+#include "Hash.hpp"
+#include "LZ4.hpp"
+
+void AssetData::SetView(const unsigned char *data, size_t size, uint64_t content_hash)
+{
+    m_Storage.clear();
+    m_Data = data;
+    m_Size = size;
+    m_ContentHash = content_hash;
+}
+
+unsigned char *AssetData::Allocate(size_t size, uint64_t content_hash)
+{
+    m_Storage.resize(size);
+    m_Data = m_Storage.data();
+    m_Size = size;
+    m_ContentHash = content_hash;
+    return m_Storage.data();
+}
+
+uint64_t AssetData::GetContentHash() const
+{
+    if(!m_ContentHash)
+        m_ContentHash = HashBytes(m_Data, m_Size);
+    return m_ContentHash;
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+bool AssetPack::Open(const std::string &path)
+{
+    Close();
+
+    if(!m_File.Open(path))
+        return false;
+
+    if(!Validate(path))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool AssetPack::Validate(const std::string &path)
+{
+    const unsigned char *mapping = m_File.GetData();
+    const size_t mapping_size = m_File.GetSize();
+    if(mapping_size < sizeof(AssetPackHeader))
+    {
+        SDL_Log("Asset pack %s is truncated.\n", path.c_str());
+        return false;
+    }
+
+    const AssetPackHeader *header = (const AssetPackHeader *)mapping;
+    if(header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION)
+    {
+        SDL_Log("Asset pack %s has an unsupported format.\n", path.c_str());
+        return false;
+    }
+    // Offsets come from the file, so the checks are written not to overflow.
+    const uint64_t toc_size = (uint64_t)header->entryCount * sizeof(AssetPackEntry);
+    if(header->tocOffset > mapping_size || toc_size > mapping_size - header->tocOffset ||
+       header->stringTableOffset > mapping_size || header->stringTableSize > mapping_size - header->stringTableOffset)
+    {
+        SDL_Log("Asset pack %s has an invalid table of contents.\n", path.c_str());
+        return false;
+    }
+
+    m_Entries = (const AssetPackEntry *)(mapping + header->tocOffset);
+    m_Strings = (const char *)(mapping + header->stringTableOffset);
+    m_EntryCount = header->entryCount;
+
+    for(uint32_t i = 0; i < m_EntryCount; i++)
+    {
+        const AssetPackEntry &entry = m_Entries[i];
+        if(entry.storedSize > mapping_size || entry.offset > mapping_size - entry.storedSize ||
+           (uint64_t)entry.pathOffset + entry.pathLength > header->stringTableSize)
+        {
+            SDL_Log("Asset pack %s has an out of range entry.\n", path.c_str());
+            return false;
+        }
+        // Read hands out a view of size bytes for stored entries, which must all be in the mapping.
+        if(!(entry.flags & ASSETPACKFLAG_LZ4) && entry.size != entry.storedSize)
+        {
+            SDL_Log("Asset pack %s has an uncompressed entry whose sizes differ.\n", path.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetPack::Close()
+{
+    m_File.Close();
+    m_Entries = nullptr;
+    m_Strings = nullptr;
+    m_EntryCount = 0;
+}
+
+const AssetPackEntry *AssetPack::Find(const std::string &path) const
+{
+    if(!m_File.IsOpen()) return nullptr;
+
+    uint64_t hash = HashBytes(path.data(), path.length());
+    const AssetPackEntry *end = m_Entries + m_EntryCount;
+    const AssetPackEntry *entry = std::lower_bound(m_Entries, end, hash,
+        [](const AssetPackEntry &entry, uint64_t hash) { return entry.pathHash < hash; });
+
+    for(; entry != end && entry->pathHash == hash; entry++)
+    {
+        if(entry->pathLength == path.length() && !memcmp(m_Strings + entry->pathOffset, path.data(), path.length()))
+            return entry;
+    }
+    return nullptr;
+}
+
+bool AssetPack::Read(const std::string &path, AssetData &data) const
+{
+    const AssetPackEntry *entry = Find(path);
+    if(!entry) return false;
+
+    const unsigned char *stored = m_File.GetData() + entry->offset;
+    if(!(entry->flags & ASSETPACKFLAG_LZ4))
+    {
+        data.SetView(stored, (size_t)entry->size, entry->contentHash);
+        return true;
+    }
+
+    unsigned char *out = data.Allocate((size_t)entry->size, entry->contentHash);
+    if(LZ4::Decompress(stored, (int)entry->storedSize, out, (int)entry->size) != (int)entry->size)
+    {
+        SDL_Log("Asset %s is corrupt in its pack.\n", path.c_str());
+        data.SetView(nullptr, 0);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "AssetPackFormat.hpp"
+#include "MappedFile.hpp"
+
+// Bytes of an asset. Points straight into a mapped pack when the entry is stored
+// uncompressed, otherwise owns the decompressed or loose-file copy.
+class AssetData
+{
+private:
+    const unsigned char *m_Data = nullptr;
+    size_t m_Size = 0;
+    mutable uint64_t m_ContentHash = 0;
+    std::vector<unsigned char> m_Storage;
+public:
+    AssetData() = default;
+    AssetData(const AssetData&) = delete;
+    AssetData(AssetData&&) = default;
+    AssetData &operator=(AssetData&&) = default;
+
+    void SetView(const unsigned char *data, size_t size, uint64_t content_hash = 0);
+    unsigned char *Allocate(size_t size, uint64_t content_hash = 0);
+
+    inline const unsigned char *GetData() const { return m_Data; }
+    inline size_t GetSize() const { return m_Size; }
+    // Taken from the pack when available, otherwise hashed on first use.
+    uint64_t GetContentHash() const;
+};
+
+class AssetPack
+{
+private:
+    MappedFile m_File;
+    const AssetPackEntry *m_Entries = nullptr;
+    const char *m_Strings = nullptr;
+    uint32_t m_EntryCount = 0;
+public:
+    AssetPack() = default;
+    AssetPack(const AssetPack&) = delete;
+    ~AssetPack();
+
+    bool Open(const std::string &path);
+    void Close();
+    inline bool IsOpen() const { return m_File.IsOpen(); }
+
+    const AssetPackEntry *Find(const std::string &path) const;
+    bool Read(const std::string &path, AssetData &data) const;
+private:
+    bool Validate(const std::string &path);
+};
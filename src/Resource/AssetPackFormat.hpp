@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of an asset pack, shared by the engine and isker-pack.
+//
+// [AssetPackHeader][entry data, each ASSET_PACK_ALIGNMENT aligned][AssetPackEntry * count][path strings]
+//
+// The table of contents is sorted by path hash so lookups are a binary search,
+// and the path strings are kept to reject hash collisions. Entries with identical
+// contents share one copy of the data and carry its hash so loads can dedupe
+// without rehashing.
+
+constexpr uint32_t ASSET_PACK_MAGIC = 0x504B5349; // "ISKP"
+constexpr uint32_t ASSET_PACK_VERSION = 2;
+constexpr uint64_t ASSET_PACK_ALIGNMENT = 16;
+
+enum AssetPackEntryFlags : uint32_t {
+    ASSETPACKFLAG_LZ4 = 1 << 0,
+};
+
+struct AssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t stringTableSize;
+    uint64_t tocOffset;
+    uint64_t stringTableOffset;
+};
+
+struct AssetPackEntry
+{
+    uint64_t pathHash;
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint64_t contentHash;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint32_t flags;
+    uint32_t padding;
+};
+
+static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader layout changed");
+static_assert(sizeof(AssetPackEntry) == 56, "AssetPackEntry layout changed");
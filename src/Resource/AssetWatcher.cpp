@@ -0,0 +1,179 @@
+#include "AssetWatcher.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include <SDL_log.h>
+#include <stb/stb_image.h>
+
+#include "../Core/AllocationTracker.hpp"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+AssetWatcher::~AssetWatcher()
+{
+    Stop();
+}
+
+#ifdef __linux__
+
+bool AssetWatcher::Start(const std::string &root, const std::string &directory)
+{
+    Stop();
+
+    m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_Notify < 0)
+    {
+        SDL_Log("Cannot start asset watcher: inotify_init1 failed.\n");
+        return false;
+    }
+
+    m_Root = root;
+    AddWatches(directory);
+    if(m_Watches.empty())
+    {
+        SDL_Log("Cannot watch asset directory %s/%s.\n", root.c_str(), directory.c_str());
+        close(m_Notify);
+        m_Notify = -1;
+        return false;
+    }
+
+    m_Running = true;
+    m_Thread = std::thread(&AssetWatcher::Run, this);
+    SDL_Log("Watching %s/%s for asset changes.\n", root.c_str(), directory.c_str());
+    return true;
+}
+
+void AssetWatcher::Stop()
+{
+    m_Running = false;
+    if(m_Thread.joinable())
+        m_Thread.join();
+    if(m_Notify >= 0)
+        close(m_Notify);
+    m_Notify = -1;
+    m_Watches.clear();
+}
+
+void AssetWatcher::AddWatches(const std::string &directory)
+{
+    const std::string full_path = m_Root + "/" + directory;
+    int watch = inotify_add_watch(m_Notify, full_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if(watch < 0)
+        return;
+    m_Watches[watch] = directory;
+
+    // inotify is not recursive, so every subdirectory needs its own watch.
+    DIR *dir = opendir(full_path.c_str());
+    if(!dir)
+        return;
+    while(dirent *entry = readdir(dir))
+    {
+        if(entry->d_type == DT_DIR && entry->d_name[0] != '.')
+            AddWatches(directory + "/" + entry->d_name);
+    }
+    closedir(dir);
+}
+
+void AssetWatcher::Run()
+{
+    AllocationTracker::SetThreadName("Asset watcher");
+    alignas(inotify_event) char buffer[4096];
+    std::vector<std::string> changed;
+
+    while(m_Running)
+    {
+        pollfd fd = { m_Notify, POLLIN, 0 };
+        if(poll(&fd, 1, 100) <= 0)
+        {
+            // Editors often write a file in several steps, so wait for a quiet
+            // period before loading everything that changed.
+            for(const std::string &path : changed)
+                Load(path);
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length;
+        while((length = read(m_Notify, buffer, sizeof(buffer))) > 0)
+        {
+            for(char *ptr = buffer; ptr < buffer + length;)
+            {
+                const inotify_event *event = (const inotify_event *)ptr;
+                ptr += sizeof(inotify_event) + event->len;
+
+                auto watch = m_Watches.find(event->wd);
+                if(watch == m_Watches.end() || !event->len)
+                    continue;
+                std::string path = watch->second + "/" + event->name;
+
+                if(event->mask & IN_ISDIR)
+                {
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO))
+                        AddWatches(path);
+                    continue;
+                }
+                if(!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                    continue;
+                if(std::find(changed.begin(), changed.end(), path) == changed.end())
+                    changed.push_back(path);
+            }
+        }
+    }
+}
+
+#else
+
+bool AssetWatcher::Start(const std::string &root, const std::string &directory)
+{
+    SDL_Log("Asset hot reload is only supported on Linux.\n");
+    return false;
+}
+
+void AssetWatcher::Stop()
+{
+}
+
+void AssetWatcher::AddWatches(const std::string &directory)
+{
+}
+
+void AssetWatcher::Run()
+{
+}
+
+#endif
+
+void AssetWatcher::Load(const std::string &path)
+{
+    Change change;
+    change.path = path;
+
+    std::ifstream stream(m_Root + "/" + path, std::ios::binary | std::ios::ate);
+    if(!stream)
+        return;
+    change.bytes.resize((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char *)change.bytes.data(), change.bytes.size());
+
+    // Decode images here so the main thread only has to upload.
+    int width, height, channels;
+    if(stbi_info_from_memory(change.bytes.data(), (int)change.bytes.size(), &width, &height, &channels) &&
+       !Texture::Decode(change.bytes.data(), (int)change.bytes.size(), change.image, path))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Changes.push_back(std::move(change));
+}
+
+void AssetWatcher::Poll(std::vector<Change> &changes)
+{
+    changes.clear();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::swap(changes, m_Changes);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../Render/Texture.hpp"
+
+// Watches an asset directory for edits (inotify, Linux only) and reads and
+// decodes changed files on a worker thread. The main thread collects the
+// results with Poll and applies them to the live GL objects.
+class AssetWatcher
+{
+public:
+    struct Change
+    {
+        // Path relative to the watch root, e.g. "asset/image/background.png".
+        std::string path;
+        std::vector<unsigned char> bytes;
+        // Decoded pixels for images, empty otherwise.
+        Texture::Image image;
+    };
+private:
+    std::string m_Root;
+    std::thread m_Thread;
+    std::atomic<bool> m_Running{ false };
+    std::mutex m_Mutex;
+    std::vector<Change> m_Changes;
+    int m_Notify = -1;
+    std::unordered_map<int, std::string> m_Watches;
+public:
+    AssetWatcher() = default;
+    AssetWatcher(const AssetWatcher&) = delete;
+    ~AssetWatcher();
+
+    // Watches root/directory recursively; reported paths are relative to root.
+    bool Start(const std::string &root, const std::string &directory);
+    void Stop();
+    // Moves every change finished since the last call into changes.
+    void Poll(std::vector<Change> &changes);
+    inline const std::string &GetRoot() const { return m_Root; }
+private:
+    void Run();
+    void AddWatches(const std::string &directory);
+    void Load(const std::string &path);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of a texture produced by isker-cook. Pixels are RGBA8, already flipped
+// to OpenGL's bottom-up row order, with every mip level stored after the header
+// so the engine can hand them to glTexImage2D without decoding.
+
+constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x544B5349; // "ISKT"
+constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+constexpr uint32_t COOKED_TEXTURE_MAX_LEVELS = 16;
+constexpr uint32_t COOKED_TEXTURE_ALIGNMENT = 16;
+constexpr const char *COOKED_TEXTURE_EXTENSION = ".itex";
+
+enum CookedTextureFlags : uint32_t {
+    COOKEDTEXTUREFLAG_FLIPPED = 1 << 0,
+    COOKEDTEXTUREFLAG_PREMULTIPLIED = 1 << 1,
+};
+
+struct CookedTextureLevel
+{
+    uint32_t offset;
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct CookedTextureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t flags;
+    uint32_t levelCount;
+    uint32_t padding;
+    CookedTextureLevel levels[COOKED_TEXTURE_MAX_LEVELS];
+};
+
+static_assert(sizeof(CookedTextureHeader) == 32 + 16 * COOKED_TEXTURE_MAX_LEVELS, "CookedTextureHeader layout changed");
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of a cached font atlas. It holds the first atlas page exactly as
+// Font::Rasterize produced it, one byte per texel, together with the glyph
+// metrics and ASCII kerning pairs, so a later launch can upload the page
+// without running FreeType.
+// A cache file is only used when the font file hash, size, rendering mode and
+// FreeType version in its header all match.
+
+constexpr uint32_t FONT_CACHE_MAGIC = 0x464B5349; // "ISKF"
+constexpr uint32_t FONT_CACHE_VERSION = 2;
+constexpr const char *FONT_CACHE_EXTENSION = ".ifnt";
+
+enum FontCacheFlags : uint32_t {
+    FONTCACHEFLAG_KERNING = 1 << 0,
+};
+
+struct FontCacheGlyph
+{
+    uint32_t codepoint;
+    uint16_t x, y;
+    uint16_t width, height;
+    int16_t bearingX, bearingY;
+    int16_t advance;
+    uint16_t page;
+};
+
+struct FontCacheKerning
+{
+    uint32_t left;
+    uint32_t right;
+    int16_t adjustment;
+    uint16_t padding;
+};
+
+struct FontCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fontHash;
+    uint32_t rasterizerVersion;
+    int32_t fontSize;
+    uint32_t rendering;
+    uint32_t pageSize;
+    uint32_t lineHeight;
+    uint32_t flags;
+    uint32_t glyphCount;
+    uint32_t shelfCount;
+    uint32_t kerningCount;
+    // Glyphs, shelves as (y, height, x) triples, kerning pairs, then pageSize * pageSize pixels.
+    uint32_t glyphOffset;
+    uint32_t shelfOffset;
+    uint32_t kerningOffset;
+    uint32_t pixelOffset;
+    uint32_t padding;
+};
+
+static_assert(sizeof(FontCacheGlyph) == 20, "FontCacheGlyph layout changed");
+static_assert(sizeof(FontCacheKerning) == 12, "FontCacheKerning layout changed");
+static_assert(sizeof(FontCacheHeader) == 72, "FontCacheHeader layout changed");
@@ -0,0 +1,169 @@
+#include "LZ4.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+static constexpr int MIN_MATCH = 4;
+static constexpr int LAST_LITERALS = 5;
+static constexpr int MF_LIMIT = 12;
+static constexpr int HASH_BITS = 12;
+static constexpr int MAX_OFFSET = 65535;
+
+static inline uint32_t Read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t HashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static inline int WriteLength(unsigned char *dst, int length)
+{
+    int written = 0;
+    while(length >= 255)
+    {
+        dst[written++] = 255;
+        length -= 255;
+    }
+    dst[written++] = (unsigned char)length;
+    return written;
+}
+
+int LZ4::CompressBound(int size)
+{
+    return size + size / 255 + 16;
+}
+
+int LZ4::Compress(const unsigned char *src, int src_size, unsigned char *dst, int dst_capacity)
+{
+    int hash_table[1 << HASH_BITS];
+    for(int &entry : hash_table)
+        entry = -1;
+
+    int ip = 0, anchor = 0, op = 0;
+
+    auto emit = [&](int literal_length, int offset, int match_length) -> bool
+    {
+        if(op + 1 + literal_length + literal_length / 255 + 1 + 2 + match_length / 255 + 1 > dst_capacity)
+            return false;
+
+        unsigned char &token = dst[op++];
+        if(literal_length >= 15)
+        {
+            token = 15 << 4;
+            op += WriteLength(dst + op, literal_length - 15);
+        }
+        else token = (unsigned char)(literal_length << 4);
+
+        memcpy(dst + op, src + anchor, literal_length);
+        op += literal_length;
+
+        // The last sequence of a block carries literals only.
+        if(offset == 0) return true;
+
+        dst[op++] = (unsigned char)(offset & 0xff);
+        dst[op++] = (unsigned char)(offset >> 8);
+
+        match_length -= MIN_MATCH;
+        if(match_length >= 15)
+        {
+            token |= 15;
+            op += WriteLength(dst + op, match_length - 15);
+        }
+        else token |= (unsigned char)match_length;
+        return true;
+    };
+
+    if(src_size > MF_LIMIT)
+    {
+        const int match_limit = src_size - LAST_LITERALS;
+        const int ip_limit = src_size - MF_LIMIT;
+        while(ip < ip_limit)
+        {
+            uint32_t sequence = Read32(src + ip);
+            uint32_t hash = HashSequence(sequence);
+            int ref = hash_table[hash];
+            hash_table[hash] = ip;
+
+            if(ref < 0 || ip - ref > MAX_OFFSET || Read32(src + ref) != sequence)
+            {
+                ip++;
+                continue;
+            }
+
+            int length = MIN_MATCH;
+            while(ip + length < match_limit && src[ref + length] == src[ip + length])
+                length++;
+
+            if(!emit(ip - anchor, ip - ref, length))
+                return 0;
+
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    if(!emit(src_size - anchor, 0, 0))
+        return 0;
+    return op;
+}
+
+int LZ4::Decompress(const unsigned char *src, int src_size, unsigned char *dst, int dst_size)
+{
+    int ip = 0, op = 0;
+
+    auto read_length = [&](int &length) -> bool
+    {
+        unsigned char b;
+        do
+        {
+            if(ip >= src_size) return false;
+            b = src[ip++];
+            length += b;
+        } while(b == 255);
+        return true;
+    };
+
+    while(ip < src_size)
+    {
+        unsigned char token = src[ip++];
+
+        int literal_length = token >> 4;
+        if(literal_length == 15 && !read_length(literal_length))
+            return -1;
+        if(ip + literal_length > src_size || op + literal_length > dst_size)
+            return -1;
+        memcpy(dst + op, src + ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if(ip == src_size)
+            break;
+
+        if(ip + 2 > src_size)
+            return -1;
+        int offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > op)
+            return -1;
+
+        int match_length = token & 15;
+        if(match_length == 15 && !read_length(match_length))
+            return -1;
+        match_length += MIN_MATCH;
+        if(op + match_length > dst_size)
+            return -1;
+
+        // Matches may overlap the bytes they produce, so copy forwards one byte at a time.
+        const unsigned char *match = dst + op - offset;
+        for(int i = 0; i < match_length; i++)
+            dst[op + i] = match[i];
+        op += match_length;
+    }
+
+    return op;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Minimal LZ4 block format codec used for compressed asset pack entries.
+namespace LZ4
+{
+    int CompressBound(int size);
+    // Returns the compressed size, or 0 if the output did not fit in dst_capacity.
+    int Compress(const unsigned char *src, int src_size, unsigned char *dst, int dst_capacity);
+    // Returns the decompressed size, or -1 if the input is malformed or overflows dst_size.
+    int Decompress(const unsigned char *src, int src_size, unsigned char *dst, int dst_size);
+}
@@ -0,0 +1,92 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = size.QuadPart ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if(!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    m_File = file;
+    m_FileMapping = mapping;
+    m_Data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    m_Size = (size_t)size.QuadPart;
+    if(!m_Data)
+    {
+        Close();
+        return false;
+    }
+#elif defined(__EMSCRIPTEN__)
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if(!stream)
+        return false;
+    m_Buffer.resize((size_t)stream.tellg());
+    if(m_Buffer.empty())
+        return false;
+    stream.seekg(0);
+    stream.read((char *)m_Buffer.data(), m_Buffer.size());
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    if(mapping == MAP_FAILED)
+        return false;
+    m_Data = (const unsigned char *)mapping;
+    m_Size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if(m_Data) UnmapViewOfFile(m_Data);
+    if(m_FileMapping) CloseHandle((HANDLE)m_FileMapping);
+    if(m_File) CloseHandle((HANDLE)m_File);
+    m_FileMapping = m_File = nullptr;
+#elif defined(__EMSCRIPTEN__)
+    m_Buffer = std::vector<unsigned char>();
+#else
+    if(m_Data) munmap((void *)m_Data, m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
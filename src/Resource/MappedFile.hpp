@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A whole file mapped read-only into memory. On the web the file system is
+// already in memory, so the file is read into a buffer instead.
+class MappedFile
+{
+private:
+    const unsigned char *m_Data = nullptr;
+    size_t m_Size = 0;
+#if defined(_WIN32)
+    void *m_File = nullptr;
+    void *m_FileMapping = nullptr;
+#elif defined(__EMSCRIPTEN__)
+    std::vector<unsigned char> m_Buffer;
+#endif
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool Open(const std::string &path);
+    void Close();
+    inline bool IsOpen() const { return m_Data != nullptr; }
+
+    inline const unsigned char *GetData() const { return m_Data; }
+    inline size_t GetSize() const { return m_Size; }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+class Texture;
+class SubTexture;
+class Font;
+class Shader;
+
+// 32-bit generational handle: the low bits index a slot in a ResourcePool,
+// the high bits hold the slot generation so stale handles resolve to nullptr.
+template<typename T>
+class ResourceHandle
+{
+public:
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+private:
+    uint32_t m_Value;
+public:
+    constexpr ResourceHandle() : m_Value(0) {}
+    constexpr ResourceHandle(uint32_t index, uint32_t generation)
+        : m_Value(((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK)) {}
+    static constexpr ResourceHandle FromValue(uint32_t value) { ResourceHandle handle; handle.m_Value = value; return handle; }
+
+    inline uint32_t GetIndex() const { return m_Value & INDEX_MASK; }
+    inline uint32_t GetGeneration() const { return m_Value >> INDEX_BITS; }
+    inline uint32_t GetValue() const { return m_Value; }
+    inline bool IsValid() const { return m_Value != 0; }
+
+    inline bool operator==(const ResourceHandle &other) const { return m_Value == other.m_Value; }
+    inline bool operator!=(const ResourceHandle &other) const { return m_Value != other.m_Value; }
+};
+
+typedef ResourceHandle<Texture> TextureHandle;
+typedef ResourceHandle<SubTexture> SubTextureHandle;
+typedef ResourceHandle<Font> FontHandle;
+typedef ResourceHandle<Shader> ShaderHandle;
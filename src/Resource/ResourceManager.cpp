@@ -0,0 +1,604 @@
+#include "ResourceManager.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+
+#include <SDL_log.h>
+
+#include "Hash.hpp"
+#include "CookedTextureFormat.hpp"
+#include "FontCacheFormat.hpp"
+#include "MappedFile.hpp"
+#include "../Core/JobSystem.hpp"
+#include "../Core/StartupReport.hpp"
+#include "../Core/FramePacer.hpp"
+
+// Seconds between checks for edited assets while the loop is otherwise idle.
+static constexpr float HOT_RELOAD_POLL_INTERVAL = 0.25f;
+
+template<typename T>
+static bool FindResource(const std::unordered_map<T, uint32_t> &map, const T &key, uint32_t &handle)
+{
+    auto found = map.find(key);
+    if(found == map.end()) return false;
+    handle = found->second;
+    return true;
+}
+
+void ResourceManager::PrefetchTexture(const std::string &path)
+{
+    if(m_TextureLookup.keys.count(path)) return;
+    Prefetch(m_PrefetchedTextures, path, [this, path](Prefetched &result) {
+        StartupReport::Scope scope("Decode " + path, true);
+        ReadTexture(path, result);
+    });
+}
+
+void ResourceManager::PrefetchFont(const std::string &path, int font_size, Font::Rendering rendering)
+{
+    const std::string key = FontKey(path, font_size, rendering);
+    if(m_FontLookup.keys.count(key)) return;
+    Prefetch(m_PrefetchedFonts, key, [this, path, font_size, rendering, key](Prefetched &result) {
+        StartupReport::Scope scope("Load font " + key, true);
+        ReadFont(path, font_size, rendering, result);
+    });
+}
+
+void ResourceManager::PrefetchShader(const std::string &vertex_path, const std::string &fragment_path)
+{
+    const std::string key = vertex_path + "|" + fragment_path;
+    if(m_ShaderLookup.keys.count(key)) return;
+    Prefetch(m_PrefetchedShaders, key, [this, vertex_path, fragment_path, key](Prefetched &result) {
+        StartupReport::Scope scope("Read " + key, true);
+        ReadShader(vertex_path, fragment_path, result);
+    });
+}
+
+void ResourceManager::Prefetch(std::unordered_map<std::string, std::unique_ptr<Prefetched>> &prefetched, const std::string &key, std::function<void(Prefetched &)> read)
+{
+    if(prefetched.count(key)) return;
+    auto result = std::make_unique<Prefetched>();
+    Prefetched *target = result.get();
+    JobSystem::Get().Submit([read, target]() { read(*target); }, &result->done, "Prefetch");
+    prefetched[key] = std::move(result);
+}
+
+std::unique_ptr<ResourceManager::Prefetched> ResourceManager::TakePrefetched(std::unordered_map<std::string, std::unique_ptr<Prefetched>> &prefetched, const std::string &key)
+{
+    auto found = prefetched.find(key);
+    if(found == prefetched.end()) return nullptr;
+    std::unique_ptr<Prefetched> result = std::move(found->second);
+    prefetched.erase(found);
+    JobSystem::Get().Wait(result->done);
+    return result;
+}
+
+void ResourceManager::ReadTexture(const std::string &path, Prefetched &result) const
+{
+    if(!ReadCookedTexture(path, result.data))
+    {
+#ifdef ISKER_REQUIRE_COOKED_ASSETS
+        SDL_Log("No cooked texture for %s\n", path.c_str());
+        return;
+#else
+        if(!ReadAsset(path, result.data))
+            return;
+#endif
+    }
+    // Hash here too so deduplication costs the main thread nothing.
+    result.data.GetContentHash();
+
+    if(!Texture::IsCooked(result.data.GetData(), (int)result.data.GetSize()) &&
+       !Texture::Decode(result.data.GetData(), (int)result.data.GetSize(), result.image, path))
+        return;
+    result.loaded = true;
+}
+
+void ResourceManager::ReadFont(const std::string &path, int font_size, Font::Rendering rendering, Prefetched &result) const
+{
+    if(!ReadAsset(path, result.data))
+        return;
+    const uint64_t font_hash = result.data.GetContentHash();
+    // The font file is still needed for glyphs outside the cached page.
+    if(ReadFontCache(font_hash, font_size, rendering, result.atlas))
+    {
+        result.atlas.fontData.assign(result.data.GetData(), result.data.GetData() + result.data.GetSize());
+        result.loaded = true;
+        return;
+    }
+    result.loaded = Font::Rasterize(result.data.GetData(), (long)result.data.GetSize(), font_size, result.atlas, path, rendering);
+    if(result.loaded)
+        WriteFontCache(font_hash, result.atlas);
+}
+
+std::string ResourceManager::FontCachePath(uint64_t font_hash, int font_size, Font::Rendering rendering) const
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%d%s", (unsigned long long)font_hash, font_size, rendering == Font::Rendering::DistanceField ? "-sdf" : "");
+    return m_FontCacheDirectory + "/" + name + FONT_CACHE_EXTENSION;
+}
+
+bool ResourceManager::ReadFontCache(uint64_t font_hash, int font_size, Font::Rendering rendering, Font::FontAtlas &atlas) const
+{
+    if(m_FontCacheDirectory.empty())
+        return false;
+    auto file = std::make_shared<MappedFile>();
+    if(!file->Open(FontCachePath(font_hash, font_size, rendering)))
+        return false;
+
+    // Anything unexpected just means the atlas is rasterized and cached again.
+    const unsigned char *data = file->GetData();
+    const size_t size = file->GetSize();
+    if(size < sizeof(FontCacheHeader))
+        return false;
+    FontCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    if(header.magic != FONT_CACHE_MAGIC || header.version != FONT_CACHE_VERSION ||
+       header.fontHash != font_hash || header.rasterizerVersion != Font::GetRasterizerVersion() ||
+       header.fontSize != font_size || header.rendering != (uint32_t)rendering ||
+       !header.pageSize || header.pageSize > 4096)
+        return false;
+    if(header.glyphOffset + (uint64_t)header.glyphCount * sizeof(FontCacheGlyph) > size ||
+       header.shelfOffset + (uint64_t)header.shelfCount * sizeof(Font::Shelf) > size ||
+       header.kerningOffset + (uint64_t)header.kerningCount * sizeof(FontCacheKerning) > size ||
+       header.pixelOffset + (uint64_t)header.pageSize * header.pageSize > size)
+        return false;
+
+    atlas.fontSize = header.fontSize;
+    atlas.rendering = rendering;
+    atlas.pageSize = header.pageSize;
+    atlas.lineHeight = header.lineHeight;
+    atlas.pixels.clear();
+    atlas.shelves.resize(header.shelfCount);
+    memcpy(atlas.shelves.data(), data + header.shelfOffset, header.shelfCount * sizeof(Font::Shelf));
+    // Packing resumes on these shelves, so each has to lie inside the page.
+    for(const Font::Shelf &shelf : atlas.shelves)
+        if(shelf.x > header.pageSize || (uint64_t)shelf.y + shelf.height > header.pageSize)
+            return false;
+    atlas.characters.resize(header.glyphCount);
+    for(uint32_t i = 0; i < header.glyphCount; i++)
+    {
+        FontCacheGlyph glyph;
+        memcpy(&glyph, data + header.glyphOffset + i * sizeof(FontCacheGlyph), sizeof(glyph));
+        // The cache only holds the first page, and a glyph outside it would sample past the atlas.
+        if(glyph.page != 0 || (uint32_t)glyph.x + glyph.width > header.pageSize || (uint32_t)glyph.y + glyph.height > header.pageSize)
+            return false;
+        Font::FontCharacter &character = atlas.characters[i].second;
+        atlas.characters[i].first = glyph.codepoint;
+        character.position = glm::u16vec2(glyph.x, glyph.y);
+        character.size = glm::u16vec2(glyph.width, glyph.height);
+        character.bearing = glm::i16vec2(glyph.bearingX, glyph.bearingY);
+        character.advance = glyph.advance;
+        character.page = glyph.page;
+    }
+    atlas.kerning = (header.flags & FONTCACHEFLAG_KERNING) != 0;
+    atlas.kerningPairs.resize(header.kerningCount);
+    for(uint32_t i = 0; i < header.kerningCount; i++)
+    {
+        FontCacheKerning pair;
+        memcpy(&pair, data + header.kerningOffset + i * sizeof(FontCacheKerning), sizeof(pair));
+        atlas.kerningPairs[i] = Font::KerningPair{ pair.left, pair.right, pair.adjustment };
+    }
+    atlas.cachePixels = data + header.pixelOffset;
+    atlas.cacheFile = std::move(file);
+    return true;
+}
+
+void ResourceManager::WriteFontCache(uint64_t font_hash, const Font::FontAtlas &atlas) const
+{
+#ifndef __EMSCRIPTEN__
+    if(m_FontCacheDirectory.empty())
+        return;
+
+    FontCacheHeader header = {};
+    header.magic = FONT_CACHE_MAGIC;
+    header.version = FONT_CACHE_VERSION;
+    header.fontHash = font_hash;
+    header.rasterizerVersion = Font::GetRasterizerVersion();
+    header.fontSize = atlas.fontSize;
+    header.rendering = (uint32_t)atlas.rendering;
+    header.pageSize = atlas.pageSize;
+    header.lineHeight = atlas.lineHeight;
+    header.flags = atlas.kerning ? FONTCACHEFLAG_KERNING : 0;
+    header.glyphCount = (uint32_t)atlas.characters.size();
+    header.shelfCount = (uint32_t)atlas.shelves.size();
+    header.kerningCount = (uint32_t)atlas.kerningPairs.size();
+    header.glyphOffset = sizeof(FontCacheHeader);
+    header.shelfOffset = header.glyphOffset + header.glyphCount * sizeof(FontCacheGlyph);
+    header.kerningOffset = header.shelfOffset + header.shelfCount * sizeof(Font::Shelf);
+    const uint32_t kerning_end = header.kerningOffset + header.kerningCount * sizeof(FontCacheKerning);
+    header.pixelOffset = (kerning_end + 15) & ~15u;
+
+    std::vector<FontCacheGlyph> glyphs(atlas.characters.size());
+    for(size_t i = 0; i < glyphs.size(); i++)
+    {
+        const Font::FontCharacter &character = atlas.characters[i].second;
+        glyphs[i] = FontCacheGlyph{ atlas.characters[i].first,
+            character.position.x, character.position.y, character.size.x, character.size.y,
+            character.bearing.x, character.bearing.y, character.advance, character.page };
+    }
+    std::vector<FontCacheKerning> kerning(atlas.kerningPairs.size());
+    for(size_t i = 0; i < kerning.size(); i++)
+        kerning[i] = FontCacheKerning{ atlas.kerningPairs[i].left, atlas.kerningPairs[i].right, atlas.kerningPairs[i].adjustment, 0 };
+
+    // Written under a temporary name and renamed, so a concurrent launch never maps half a file.
+    const std::string path = FontCachePath(font_hash, atlas.fontSize, atlas.rendering);
+    const std::string temporary_path = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(m_FontCacheDirectory, error);
+    {
+        std::ofstream stream(temporary_path, std::ios::binary);
+        const char zeros[16] = {};
+        stream.write((const char *)&header, sizeof(header));
+        stream.write((const char *)glyphs.data(), glyphs.size() * sizeof(FontCacheGlyph));
+        stream.write((const char *)atlas.shelves.data(), atlas.shelves.size() * sizeof(Font::Shelf));
+        stream.write((const char *)kerning.data(), kerning.size() * sizeof(FontCacheKerning));
+        stream.write(zeros, header.pixelOffset - kerning_end);
+        stream.write((const char *)atlas.GetPixels(), (size_t)atlas.pageSize * atlas.pageSize);
+        if(!stream)
+        {
+            SDL_Log("Cannot write font cache %s\n", path.c_str());
+            stream.close();
+            std::filesystem::remove(temporary_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary_path, path, error);
+    if(error)
+        std::filesystem::remove(temporary_path, error);
+#endif
+}
+
+std::string ResourceManager::FontKey(const std::string &path, int font_size, Font::Rendering rendering)
+{
+    return path + "@" + std::to_string(font_size) + (rendering == Font::Rendering::DistanceField ? ":sdf" : "");
+}
+
+void ResourceManager::ReadShader(const std::string &vertex_path, const std::string &fragment_path, Prefetched &result) const
+{
+    if(!ReadAsset(vertex_path, result.data) || !ReadAsset(fragment_path, result.fragmentData))
+        return;
+    result.data.GetContentHash();
+    result.fragmentData.GetContentHash();
+    result.loaded = true;
+}
+
+TextureHandle ResourceManager::LoadTexture(const std::string &path)
+{
+    uint32_t handle;
+    if(FindResource(m_TextureLookup.keys, path, handle))
+        return TextureHandle::FromValue(handle);
+
+    std::unique_ptr<Prefetched> prefetched = TakePrefetched(m_PrefetchedTextures, path);
+    if(!prefetched)
+    {
+        prefetched = std::make_unique<Prefetched>();
+        ReadTexture(path, *prefetched);
+    }
+    if(!prefetched->loaded)
+        return TextureHandle();
+
+    uint64_t hash = prefetched->data.GetContentHash();
+    if(FindResource(m_TextureLookup.contents, hash, handle))
+    {
+        // Callers of either path hold the same handle, so editing either
+        // file reloads the one shared texture.
+        m_TextureLookup.keys[path] = handle;
+        AddReloadTarget(path, ReloadTarget{ ReloadTarget::Type::Texture, handle });
+        return TextureHandle::FromValue(handle);
+    }
+
+    std::shared_ptr<Texture> resource = prefetched->image.pixels
+        ? std::make_shared<Texture>(prefetched->image)
+        : std::make_shared<Texture>(prefetched->data.GetData(), (int)prefetched->data.GetSize(), path);
+    TextureHandle texture = m_Textures.Insert(std::move(resource));
+    m_TextureLookup.keys[path] = texture.GetValue();
+    m_TextureLookup.contents[hash] = texture.GetValue();
+    AddReloadTarget(path, ReloadTarget{ ReloadTarget::Type::Texture, texture.GetValue() });
+    return texture;
+}
+
+SubTextureHandle ResourceManager::CreateSubTexture(TextureHandle texture, int top, int left, int bottom, int right)
+{
+    return CreateSubTexture(m_Textures.GetShared(texture), texture.GetValue(), top, left, bottom, right);
+}
+
+SubTextureHandle ResourceManager::CreateSubTexture(SubTextureHandle texture, int top, int left, int bottom, int right)
+{
+    // Tag the key so a texture and a sub texture sharing a handle value never collide.
+    return CreateSubTexture(m_SubTextures.GetShared(texture), (1ull << 32) | texture.GetValue(), top, left, bottom, right);
+}
+
+SubTextureHandle ResourceManager::CreateSubTexture(const std::shared_ptr<Texture> &texture, uint64_t parent_key, int top, int left, int bottom, int right)
+{
+    if(!texture)
+    {
+        SDL_Log("Cannot create sub texture of an invalid texture handle.\n");
+        return SubTextureHandle();
+    }
+
+    const int rect[4] = { top, left, bottom, right };
+    uint64_t hash = HashBytes(rect, sizeof(rect), HashBytes(&parent_key, sizeof(parent_key)));
+
+    uint32_t handle;
+    if(FindResource(m_SubTextureLookup.contents, hash, handle))
+        return SubTextureHandle::FromValue(handle);
+
+    SubTextureHandle subTexture = m_SubTextures.Insert(std::make_shared<SubTexture>(texture, top, left, bottom, right));
+    m_SubTextureLookup.contents[hash] = subTexture.GetValue();
+    return subTexture;
+}
+
+FontHandle ResourceManager::LoadFont(const std::string &path, int font_size, Font::Rendering rendering)
+{
+    const std::string key = FontKey(path, font_size, rendering);
+
+    uint32_t handle;
+    if(FindResource(m_FontLookup.keys, key, handle))
+        return FontHandle::FromValue(handle);
+
+    std::unique_ptr<Prefetched> prefetched = TakePrefetched(m_PrefetchedFonts, key);
+    if(!prefetched)
+    {
+        prefetched = std::make_unique<Prefetched>();
+        ReadFont(path, font_size, rendering, *prefetched);
+    }
+    if(!prefetched->loaded)
+        return FontHandle();
+
+    uint64_t hash = HashBytes(&font_size, sizeof(font_size), prefetched->data.GetContentHash());
+    hash = HashBytes(&rendering, sizeof(rendering), hash);
+    if(FindResource(m_FontLookup.contents, hash, handle))
+    {
+        m_FontLookup.keys[key] = handle;
+        AddReloadTarget(path, ReloadTarget{ ReloadTarget::Type::Font, handle });
+        return FontHandle::FromValue(handle);
+    }
+
+    FontHandle font = m_Fonts.Insert(std::make_shared<Font>(std::move(prefetched->atlas), path));
+    m_FontLookup.keys[key] = font.GetValue();
+    m_FontLookup.contents[hash] = font.GetValue();
+    AddReloadTarget(path, ReloadTarget{ ReloadTarget::Type::Font, font.GetValue() });
+    return font;
+}
+
+ShaderHandle ResourceManager::LoadShader(const std::string &vertex_path, const std::string &fragment_path)
+{
+    const std::string key = vertex_path + "|" + fragment_path;
+
+    uint32_t handle;
+    if(FindResource(m_ShaderLookup.keys, key, handle))
+        return ShaderHandle::FromValue(handle);
+
+    std::unique_ptr<Prefetched> prefetched = TakePrefetched(m_PrefetchedShaders, key);
+    if(!prefetched)
+    {
+        prefetched = std::make_unique<Prefetched>();
+        ReadShader(vertex_path, fragment_path, *prefetched);
+    }
+    if(!prefetched->loaded)
+        return ShaderHandle();
+    const AssetData &vertex_source = prefetched->data;
+    const AssetData &fragment_source = prefetched->fragmentData;
+
+    uint64_t hashes[2] = { vertex_source.GetContentHash(), fragment_source.GetContentHash() };
+    uint64_t hash = HashBytes(hashes, sizeof(hashes));
+    if(FindResource(m_ShaderLookup.contents, hash, handle))
+    {
+        m_ShaderLookup.keys[key] = handle;
+        AddReloadTarget(vertex_path, ReloadTarget{ ReloadTarget::Type::Shader, handle, vertex_path, fragment_path });
+        AddReloadTarget(fragment_path, ReloadTarget{ ReloadTarget::Type::Shader, handle, vertex_path, fragment_path });
+        return ShaderHandle::FromValue(handle);
+    }
+
+    ShaderHandle shader = m_Shaders.Insert(std::make_shared<Shader>(
+        (const char *)vertex_source.GetData(), (int)vertex_source.GetSize(),
+        (const char *)fragment_source.GetData(), (int)fragment_source.GetSize(),
+        key));
+    m_ShaderLookup.keys[key] = shader.GetValue();
+    m_ShaderLookup.contents[hash] = shader.GetValue();
+    AddReloadTarget(vertex_path, ReloadTarget{ ReloadTarget::Type::Shader, shader.GetValue(), vertex_path, fragment_path });
+    AddReloadTarget(fragment_path, ReloadTarget{ ReloadTarget::Type::Shader, shader.GetValue(), vertex_path, fragment_path });
+    return shader;
+}
+
+bool ResourceManager::EnableHotReload(const std::string &root)
+{
+    m_Watcher = std::make_unique<AssetWatcher>();
+    if(m_Watcher->Start(root, "asset"))
+        return true;
+    m_Watcher.reset();
+    return false;
+}
+
+void ResourceManager::Update()
+{
+    if(!m_Watcher) return;
+
+    m_Watcher->Poll(m_Changes);
+    for(const AssetWatcher::Change &change : m_Changes)
+        ApplyChange(change);
+    const bool fonts_reloaded = AdoptFontReloads();
+    // The watcher is only polled from here, so an idle on-demand loop still
+    // wakes up now and then to look for edits.
+    if(!m_Changes.empty() || fonts_reloaded)
+        FramePacer::Get().RequestRedraw();
+    FramePacer::Get().RequestRedrawIn(HOT_RELOAD_POLL_INTERVAL);
+}
+
+void ResourceManager::ApplyChange(const AssetWatcher::Change &change)
+{
+    auto targets = m_ReloadTargets.equal_range(change.path);
+    for(auto it = targets.first; it != targets.second; it++)
+    {
+        const ReloadTarget &target = it->second;
+        switch(target.type)
+        {
+        case ReloadTarget::Type::Texture:
+        {
+            Texture *texture = m_Textures.Get(TextureHandle::FromValue(target.handle));
+            if(!texture || !change.image.pixels) break;
+            texture->Reload(change.image);
+            ForgetContent(m_TextureLookup, target.handle);
+            break;
+        }
+        case ReloadTarget::Type::Font:
+        {
+            Font *font = m_Fonts.Get(FontHandle::FromValue(target.handle));
+            if(!font) break;
+            // Rasterizing takes too long for the main thread, so only the upload happens here.
+            auto result = std::make_unique<Prefetched>();
+            Prefetched *pending = result.get();
+            const int font_size = (int)font->GetFontSize();
+            const Font::Rendering rendering = font->GetRendering();
+            JobSystem::Get().Submit([pending, bytes = change.bytes, font_size, rendering, path = change.path]() {
+                pending->loaded = Font::Rasterize(bytes.data(), (long)bytes.size(), font_size, pending->atlas, path, rendering);
+            }, &result->done, "Reload font");
+            m_FontReloads.push_back(FontReload{ target.handle, change.path, std::move(result) });
+            // Logged by AdoptFontReloads.
+            continue;
+        }
+        case ReloadTarget::Type::Shader:
+        {
+            Shader *shader = m_Shaders.Get(ShaderHandle::FromValue(target.handle));
+            if(!shader) break;
+            // Only one stage changed; the other is small enough to read again here.
+            const bool vertex_changed = change.path == target.vertexPath;
+            AssetData other;
+            if(!ReadFile(m_Watcher->GetRoot() + "/" + (vertex_changed ? target.fragmentPath : target.vertexPath), other))
+                break;
+            const char *changed_source = (const char *)change.bytes.data();
+            const char *other_source = (const char *)other.GetData();
+            if(vertex_changed)
+                shader->Reload(changed_source, (int)change.bytes.size(), other_source, (int)other.GetSize(), change.path);
+            else
+                shader->Reload(other_source, (int)other.GetSize(), changed_source, (int)change.bytes.size(), change.path);
+            ForgetContent(m_ShaderLookup, target.handle);
+            break;
+        }
+        }
+        SDL_Log("Reloaded %s\n", change.path.c_str());
+    }
+}
+
+bool ResourceManager::AdoptFontReloads()
+{
+    // In the order they were started, so a font edited twice ends up with the later file.
+    size_t finished = 0;
+    for(; finished < m_FontReloads.size() && m_FontReloads[finished].result->done.IsDone(); finished++)
+    {
+        FontReload &reload = m_FontReloads[finished];
+        JobSystem::Get().Wait(reload.result->done);
+        Font *font = m_Fonts.Get(FontHandle::FromValue(reload.handle));
+        if(!font || !reload.result->loaded) continue;
+        font->Reload(std::move(reload.result->atlas), reload.path);
+        ForgetContent(m_FontLookup, reload.handle);
+        SDL_Log("Reloaded %s\n", reload.path.c_str());
+    }
+    m_FontReloads.erase(m_FontReloads.begin(), m_FontReloads.begin() + finished);
+    return finished != 0;
+}
+
+void ResourceManager::AddReloadTarget(const std::string &path, const ReloadTarget &target)
+{
+    // An alias can share a file with the resource it aliases, which should still reload once.
+    auto targets = m_ReloadTargets.equal_range(path);
+    for(auto it = targets.first; it != targets.second; it++)
+        if(it->second.type == target.type && it->second.handle == target.handle)
+            return;
+    m_ReloadTargets.emplace(path, target);
+}
+
+void ResourceManager::ForgetContent(LookupTable &lookup, uint32_t handle)
+{
+    // The resource no longer matches the content it was deduplicated by.
+    for(auto it = lookup.contents.begin(); it != lookup.contents.end();)
+    {
+        if(it->second == handle) it = lookup.contents.erase(it);
+        else it++;
+    }
+}
+
+void ResourceManager::Clear()
+{
+    // Worker tasks write into these, so let them finish before anything is freed.
+    for(auto *prefetched : { &m_PrefetchedTextures, &m_PrefetchedFonts, &m_PrefetchedShaders })
+    {
+        for(auto &pending : *prefetched)
+            JobSystem::Get().Wait(pending.second->done);
+        prefetched->clear();
+    }
+    for(FontReload &reload : m_FontReloads)
+        JobSystem::Get().Wait(reload.result->done);
+    m_FontReloads.clear();
+
+    m_Watcher.reset();
+    m_ReloadTargets.clear();
+
+    m_SubTextures.Clear();
+    m_Textures.Clear();
+    m_Fonts.Clear();
+    m_Shaders.Clear();
+
+    m_TextureLookup = LookupTable();
+    m_SubTextureLookup = LookupTable();
+    m_FontLookup = LookupTable();
+    m_ShaderLookup = LookupTable();
+
+    m_Packs.clear();
+}
+
+bool ResourceManager::MountPack(const std::string &path)
+{
+    auto pack = std::make_unique<AssetPack>();
+    if(!pack->Open(path))
+        return false;
+    m_Packs.push_back(std::move(pack));
+    return true;
+}
+
+bool ResourceManager::ReadAsset(const std::string &path, AssetData &data) const
+{
+    for(auto pack = m_Packs.rbegin(); pack != m_Packs.rend(); pack++)
+    {
+        if((*pack)->Read(path, data))
+            return true;
+    }
+    if(ReadFile(path, data))
+        return true;
+
+    SDL_Log("Cannot open file %s\n", path.c_str());
+    return false;
+}
+
+bool ResourceManager::ReadCookedTexture(const std::string &path, AssetData &data) const
+{
+    size_t extension = path.find_last_of('.');
+    size_t directory = path.find_last_of('/');
+    if(extension == std::string::npos || (directory != std::string::npos && extension < directory))
+        extension = path.length();
+    const std::string cooked_path = path.substr(0, extension) + COOKED_TEXTURE_EXTENSION;
+
+    for(auto pack = m_Packs.rbegin(); pack != m_Packs.rend(); pack++)
+    {
+        if((*pack)->Read(cooked_path, data))
+            return true;
+    }
+
+    return ReadFile(cooked_path, data);
+}
+
+bool ResourceManager::ReadFile(const std::string &path, AssetData &data)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if(!stream)
+        return false;
+
+    unsigned char *bytes = data.Allocate((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char *)bytes, data.GetSize());
+    return true;
+}
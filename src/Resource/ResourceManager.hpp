@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "../Singleton.hpp"
+#include "../Core/JobSystem.hpp"
+#include "../Render/Texture.hpp"
+#include "../Render/Font.hpp"
+#include "../Render/Shader.hpp"
+#include "ResourceHandle.hpp"
+#include "ResourcePool.hpp"
+#include "AssetPack.hpp"
+#include "AssetWatcher.hpp"
+
+class ResourceManager
+{
+    SINGLETON(ResourceManager);
+private:
+    // Resources are deduplicated first by the key they were requested with and
+    // then by a hash of their file contents, so copies of an asset share one GPU object.
+    struct LookupTable
+    {
+        std::unordered_map<std::string, uint32_t> keys;
+        std::unordered_map<uint64_t, uint32_t> contents;
+    };
+    ResourcePool<Texture> m_Textures;
+    ResourcePool<SubTexture> m_SubTextures;
+    ResourcePool<Font> m_Fonts;
+    ResourcePool<Shader> m_Shaders;
+    LookupTable m_TextureLookup;
+    LookupTable m_SubTextureLookup;
+    LookupTable m_FontLookup;
+    LookupTable m_ShaderLookup;
+    std::vector<std::unique_ptr<AssetPack>> m_Packs;
+    // Which live resources were loaded from a given file, for hot reload.
+    struct ReloadTarget
+    {
+        enum class Type { Texture, Font, Shader } type;
+        uint32_t handle;
+        std::string vertexPath, fragmentPath;
+    };
+    std::unordered_multimap<std::string, ReloadTarget> m_ReloadTargets;
+    std::unique_ptr<AssetWatcher> m_Watcher;
+    std::vector<AssetWatcher::Change> m_Changes;
+    // CPU-side work for one asset: file reads, image decoding or glyph rasterization.
+    // Produced by a job from Prefetch* or inline by Load*, consumed by Load*.
+    struct Prefetched
+    {
+        AssetData data, fragmentData;
+        Texture::Image image;
+        Font::FontAtlas atlas;
+        bool loaded = false;
+        JobCounter done;
+    };
+    std::unordered_map<std::string, std::unique_ptr<Prefetched>> m_PrefetchedTextures;
+    std::unordered_map<std::string, std::unique_ptr<Prefetched>> m_PrefetchedFonts;
+    std::unordered_map<std::string, std::unique_ptr<Prefetched>> m_PrefetchedShaders;
+    std::string m_FontCacheDirectory = "cache/font";
+    // Edited fonts are rasterized by a job and adopted by Update once it finishes.
+    struct FontReload
+    {
+        uint32_t handle;
+        std::string path;
+        std::unique_ptr<Prefetched> result;
+    };
+    std::vector<FontReload> m_FontReloads;
+public:
+    // Mounted packs are searched newest first; anything not found falls back to loose files.
+    bool MountPack(const std::string &path);
+    bool ReadAsset(const std::string &path, AssetData &data) const;
+
+    // Start the CPU half of a load as a job. The matching Load* call
+    // then waits for it and only does the GL upload. Packs must be mounted first.
+    void PrefetchTexture(const std::string &path);
+    void PrefetchFont(const std::string &path, int font_size, Font::Rendering rendering = Font::Rendering::Bitmap);
+    void PrefetchShader(const std::string &vertex_path, const std::string &fragment_path);
+
+    TextureHandle LoadTexture(const std::string &path);
+    SubTextureHandle CreateSubTexture(TextureHandle texture, int top, int left, int bottom, int right);
+    SubTextureHandle CreateSubTexture(SubTextureHandle texture, int top, int left, int bottom, int right);
+    // Distance-field fonts are rasterized once at font_size (usually
+    // Font::DISTANCE_FIELD_SIZE) and drawn at any size.
+    FontHandle LoadFont(const std::string &path, int font_size, Font::Rendering rendering = Font::Rendering::Bitmap);
+    // Rasterized atlases are saved here and mapped back in on later launches
+    // instead of running FreeType. An empty directory disables the cache.
+    inline void SetFontCacheDirectory(const std::string &directory) { m_FontCacheDirectory = directory; }
+    ShaderHandle LoadShader(const std::string &vertex_path, const std::string &fragment_path);
+
+    inline Texture *GetTexture(TextureHandle handle) const { return m_Textures.Get(handle); }
+    inline SubTexture *GetSubTexture(SubTextureHandle handle) const { return m_SubTextures.Get(handle); }
+    inline Font *GetFont(FontHandle handle) const { return m_Fonts.Get(handle); }
+    inline Shader *GetShader(ShaderHandle handle) const { return m_Shaders.Get(handle); }
+
+    // Watches root/asset for edits and reloads changed textures, fonts and shaders
+    // in place, so every existing handle stays valid.
+    bool EnableHotReload(const std::string &root);
+    // Applies finished reloads. Call once per frame on the thread that owns the GL context.
+    void Update();
+
+    // Releases every resource. Must be called while the OpenGL context is still alive.
+    void Clear();
+private:
+    SubTextureHandle CreateSubTexture(const std::shared_ptr<Texture> &texture, uint64_t parent_key, int top, int left, int bottom, int right);
+    void ReadTexture(const std::string &path, Prefetched &result) const;
+    void ReadFont(const std::string &path, int font_size, Font::Rendering rendering, Prefetched &result) const;
+    static std::string FontKey(const std::string &path, int font_size, Font::Rendering rendering);
+    std::string FontCachePath(uint64_t font_hash, int font_size, Font::Rendering rendering) const;
+    bool ReadFontCache(uint64_t font_hash, int font_size, Font::Rendering rendering, Font::FontAtlas &atlas) const;
+    void WriteFontCache(uint64_t font_hash, const Font::FontAtlas &atlas) const;
+    void ReadShader(const std::string &vertex_path, const std::string &fragment_path, Prefetched &result) const;
+    void Prefetch(std::unordered_map<std::string, std::unique_ptr<Prefetched>> &prefetched, const std::string &key, std::function<void(Prefetched &)> read);
+    static std::unique_ptr<Prefetched> TakePrefetched(std::unordered_map<std::string, std::unique_ptr<Prefetched>> &prefetched, const std::string &key);
+    void ApplyChange(const AssetWatcher::Change &change);
+    // Returns whether any reload finished.
+    bool AdoptFontReloads();
+    void AddReloadTarget(const std::string &path, const ReloadTarget &target);
+    static void ForgetContent(LookupTable &lookup, uint32_t handle);
+    // Looks for the isker-cook output next to a source image, e.g. foo.png -> foo.itex.
+    bool ReadCookedTexture(const std::string &path, AssetData &data) const;
+    static bool ReadFile(const std::string &path, AssetData &data);
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <SDL_log.h>
+
+#include "ResourceHandle.hpp"
+
+template<typename T>
+class ResourcePool
+{
+private:
+    struct Slot
+    {
+        std::shared_ptr<T> resource;
+        uint32_t generation = 1;
+    };
+    std::vector<Slot> m_Slots;
+    std::vector<uint32_t> m_FreeSlots;
+public:
+    ResourceHandle<T> Insert(std::shared_ptr<T> resource)
+    {
+        uint32_t index;
+        if(!m_FreeSlots.empty())
+        {
+            index = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            if(m_Slots.size() > ResourceHandle<T>::INDEX_MASK)
+            {
+                SDL_Log("Resource pool is full!\n");
+                return ResourceHandle<T>();
+            }
+            index = (uint32_t)m_Slots.size();
+            m_Slots.emplace_back();
+        }
+        m_Slots[index].resource = std::move(resource);
+        return ResourceHandle<T>(index, m_Slots[index].generation);
+    }
+
+    inline T *Get(ResourceHandle<T> handle) const
+    {
+        uint32_t index = handle.GetIndex();
+        if(index >= m_Slots.size() || m_Slots[index].generation != handle.GetGeneration())
+            return nullptr;
+        return m_Slots[index].resource.get();
+    }
+
+    const std::shared_ptr<T> &GetShared(ResourceHandle<T> handle) const
+    {
+        static const std::shared_ptr<T> null;
+        uint32_t index = handle.GetIndex();
+        if(index >= m_Slots.size() || m_Slots[index].generation != handle.GetGeneration())
+            return null;
+        return m_Slots[index].resource;
+    }
+
+    bool Remove(ResourceHandle<T> handle)
+    {
+        uint32_t index = handle.GetIndex();
+        if(index >= m_Slots.size() || m_Slots[index].generation != handle.GetGeneration())
+            return false;
+        Slot &slot = m_Slots[index];
+        slot.resource.reset();
+        // Generation 0 is reserved so a default constructed handle never resolves.
+        slot.generation = (slot.generation + 1) & ResourceHandle<T>::GENERATION_MASK;
+        if(!slot.generation) slot.generation = 1;
+        m_FreeSlots.push_back(index);
+        return true;
+    }
+
+    void Clear()
+    {
+        // Release newest first so resources go before anything they were built from.
+        for(uint32_t i = (uint32_t)m_Slots.size(); i-- > 0;)
+        {
+            if(m_Slots[i].resource)
+                Remove(ResourceHandle<T>(i, m_Slots[i].generation));
+        }
+    }
+};
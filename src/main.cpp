@@ -1,5 +1,7 @@
 #include <SDL.h>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 #if __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -8,84 +10,244 @@
 #include "Render/Renderer.hpp"
 #include "Game.hpp"
 #include "Input.hpp"
+#include "Resource/ResourceManager.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/StartupReport.hpp"
+#include "Core/FrameGraph.hpp"
+#include "Core/FramePacer.hpp"
+#include "Core/Simulation.hpp"
+#include "Core/Replay.hpp"
+#include "Core/AllocationTracker.hpp"
 
 
 static bool bRunning = 1;
+static FrameGraph frameGraph;
+// Frames after startup before any allocation counts against steady state.
+static const uint64_t STEADY_STATE_WARMUP_FRAMES = 300;
+
+// Window events are handled here; input goes to the simulation, which
+// applies it in the tick it happened in. frame is the frame the event is
+// handled for.
+static void handleEvent(const SDL_Event &event, uint64_t frame)
+{
+    Simulation &simulation = Simulation::Get();
+    switch(event.type)
+    {
+    case SDL_QUIT:
+        bRunning = false;
+        break;
+    case SDL_WINDOWEVENT:
+        switch(event.window.event)
+        {
+        case SDL_WINDOWEVENT_RESIZED:
+            // During playback the window is sized from the log alone.
+            if(Replay::Get().IsPlaying()) break;
+            Renderer::Get().OnResize(event.window.data1, event.window.data2);
+            Replay::Get().RecordResize(frame, event.window.data1, event.window.data2);
+            break;
+        }
+        break;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        if(!event.key.repeat)
+            simulation.PushEvent(InputEvent{ InputEvent::Type::Key, event.key.state == SDL_PRESSED, event.key.keysym.scancode });
+        break;
+    case SDL_MOUSEMOTION:
+        simulation.PushEvent(InputEvent{ InputEvent::Type::MouseMotion, false, 0, event.motion.x, event.motion.y, event.motion.xrel, event.motion.yrel });
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        simulation.PushEvent(InputEvent{ InputEvent::Type::MouseButton, event.button.state == SDL_PRESSED, event.button.button });
+        break;
+    case SDL_MOUSEWHEEL:
+        simulation.PushEvent(InputEvent{ InputEvent::Type::MouseWheel, false, event.wheel.y });
+        break;
+    }
+}
 
 void gameLoop()
 {
     SDL_Event event;
+    FramePacer &pacer = FramePacer::Get();
 
     while(bRunning)
     {
-        while(SDL_PollEvent(&event))
+        // In on-demand mode, sleep until an event arrives or a redraw is due.
+        // Events are handled here directly, so no frame may still be running.
+        if(pacer.IsOnDemand() && pacer.GetIdleTimeout() != 0)
+            frameGraph.Flush();
+        for(int timeout; bRunning && (timeout = pacer.GetIdleTimeout()) != 0;)
         {
-            switch(event.type)
+            if(SDL_WaitEventTimeout(&event, timeout))
             {
-            case SDL_QUIT:
-                bRunning = false;
-                break;
-            case SDL_WINDOWEVENT:
-                switch(event.window.event)
-                {
-                case SDL_WINDOWEVENT_RESIZED:
-                    Renderer::Get().OnResize(event.window.data1, event.window.data2);
-                    break;
-                }
-                break;
-            case SDL_KEYDOWN:
-            case SDL_KEYUP:
-                if(!event.key.repeat)
-                    Input::Get().HandleKeyboard(event.key.keysym.scancode, event.key.state);
-                break;
-            case SDL_MOUSEMOTION:
-                Input::Get().HandleMouseMovement(event.motion.x, event.motion.y, event.motion.xrel, event.motion.yrel);
-                break;
-            case SDL_MOUSEBUTTONDOWN:
-            case SDL_MOUSEBUTTONUP:
-                Input::Get().HandleMouseButton(event.button.button, event.button.state);
-                break;
-            case SDL_MOUSEWHEEL:
-                Input::Get().HandleMouseWheel(event.wheel.y);
-                break;
+                handleEvent(event, frameGraph.GetFrameCount());
+                pacer.RequestRedraw();
             }
         }
-        
+
+        // Waits out the frame limiter, or in low-latency mode until just
+        // before the swap deadline, so the events polled by the graph's input
+        // stage are as fresh as possible.
+        pacer.BeginFrame();
+
         static Uint64 last_frame = SDL_GetPerformanceCounter();
         Uint64 now = SDL_GetPerformanceCounter();
         float delta = (float)(now - last_frame) / SDL_GetPerformanceFrequency();
         last_frame = now;
+
+        // Playback measures the real frame time, then runs the frame with the recorded delta.
+        Replay &replay = Replay::Get();
+        if(replay.IsPlaying() && frameGraph.GetFrameCount())
+            replay.AddFrameTime(delta);
         if (delta >= 0.1f)
             delta = 0.1f;
+        if(!replay.NextFrame(delta))
+        {
+            bRunning = false;
+            break;
+        }
+
+        JobSystem::Get().RunMainThreadJobs();
+        frameGraph.Execute(delta);
+
+        // With two frames in flight the first one is done a loop later.
+        static const Uint64 first_frame = now;
+        if(!StartupReport::Get().IsFinished() && frameGraph.GetFrameCount() >= frameGraph.GetFramesInFlight())
+        {
+            StartupReport::Get().Record("First frame", first_frame, SDL_GetPerformanceCounter());
+            StartupReport::Get().Finish();
+        }
 
-        Game::Get().Frame(delta);
-        Input::Get().Frame();
+        AllocationTracker &tracker = AllocationTracker::Get();
+        tracker.EndFrame();
+        if(tracker.IsEnabled() && !tracker.IsSteadyState() && StartupReport::Get().IsFinished() && frameGraph.GetFrameCount() >= STEADY_STATE_WARMUP_FRAMES)
+            tracker.SetSteadyState(true);
     }
 }
 
 int main(int argc, char* argv[])
 {
+    // SDL's allocator can only be swapped before SDL allocates anything.
+    AllocationTracker::Get().InstallSDLHooks();
+    AllocationTracker::SetThreadName("Main");
     if(SDL_Init(SDL_INIT_VIDEO) != 0)
     {
         SDL_Log("Failed SDL Init!\n");
         exit(0);
     }
 
-    SDL_Window *pWindow = SDL_CreateWindow("Ikser",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        1280, 720,
-        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
-    
+    // Recording and playback are set up before anything that reads input or creates the window.
+    bool headless = false, fixed_step = false;
+    const char *baseline_path = nullptr, *save_baseline_path = nullptr;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strncmp(argv[i], "--record=", 9))
+            Replay::Get().StartRecording(argv[i] + 9);
+        else if(!strncmp(argv[i], "--replay=", 9))
+        {
+            if(!Replay::Get().StartPlayback(argv[i] + 9))
+                exit(1);
+        }
+        else if(!strcmp(argv[i], "--replay-fixed-step"))
+            fixed_step = true;
+        else if(!strcmp(argv[i], "--headless"))
+            headless = true;
+        else if(!strncmp(argv[i], "--baseline=", 11))
+            baseline_path = argv[i] + 11;
+        else if(!strncmp(argv[i], "--save-baseline=", 16))
+            save_baseline_path = argv[i] + 16;
+        else if(!strcmp(argv[i], "--alloc-assert"))
+            AllocationTracker::Get().SetViolationMode(AllocationTracker::Violation::Assert);
+    }
+    StartupReport::Get().Start();
+    JobSystem::Get().Init();
+
+    {
+        StartupReport::Scope scope("Mount asset pack");
+        if(!ResourceManager::Get().MountPack("asset.pak"))
+            SDL_Log("No asset pack found, reading loose files.\n");
+    }
+
+    // Decoding and rasterization run as jobs while the window and GL context come up.
+    Renderer::Get().Preload();
+    Game::Get().Preload();
+
+    SDL_Window *pWindow;
+    {
+        StartupReport::Scope scope("Create window");
+        pWindow = SDL_CreateWindow("Ikser",
+            SDL_WINDOWPOS_CENTERED,
+            SDL_WINDOWPOS_CENTERED,
+            1280, 720,
+            SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | (headless ? SDL_WINDOW_HIDDEN : 0));
+    }
+
     if(!pWindow)
     {
         SDL_Log("Failed to create window!\n");
         exit(0);
     }
 
-    Renderer::Get().Init(pWindow);
-    Game::Get().Init(pWindow);
+    {
+        StartupReport::Scope scope("Renderer init");
+        Renderer::Get().Init(pWindow);
+    }
+    {
+        int width, height;
+        SDL_GetWindowSize(pWindow, &width, &height);
+        Replay::Get().RecordResize(0, width, height);
+    }
+    bool dump_frame_graph = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--vsync=off"))
+            FramePacer::Get().SetVSync(FramePacer::VSync::Off);
+        else if(!strcmp(argv[i], "--vsync=on"))
+            FramePacer::Get().SetVSync(FramePacer::VSync::On);
+        else if(!strncmp(argv[i], "--fps-cap=", 10))
+            FramePacer::Get().SetFrameCap((float)atof(argv[i] + 10));
+        else if(!strcmp(argv[i], "--low-latency"))
+            FramePacer::Get().SetLowLatency(true);
+        else if(!strcmp(argv[i], "--on-demand"))
+            FramePacer::Get().SetOnDemand(true);
+        else if(!strcmp(argv[i], "--dump-frame-graph"))
+            dump_frame_graph = true;
+    }
+    // The simulation thread Game::Init starts reads input from its first tick.
     Input::Get().Init();
+    {
+        StartupReport::Scope scope("Game init");
+        Game::Get().Init(pWindow);
+    }
+    // Headless playback draws off screen as fast as it can, which is what the frame times should measure.
+    if(headless)
+        FramePacer::Get().SetUnpaced(true);
+    // One tick per frame, so runs on different machines do the same work per frame.
+    if(fixed_step)
+        Replay::Get().SetFixedDelta(Simulation::Get().GetStep());
+
+    // Events and asset reloads touch SDL and OpenGL, so they stay on the main thread.
+    frameGraph.AddStage("Input", {}, { "Input" }, [pWindow](const FrameGraph::FrameInfo &frame) {
+        SDL_Event event;
+        while(SDL_PollEvent(&event))
+            handleEvent(event, frame.index);
+        for(int width, height; Replay::Get().NextResize(frame.index, width, height);)
+        {
+            SDL_SetWindowSize(pWindow, width, height);
+            Renderer::Get().OnResize(width, height);
+        }
+    }, FrameGraph::Affinity::MainThread);
+    frameGraph.AddStage("Assets", {}, { "Assets" }, [](const FrameGraph::FrameInfo &) {
+        ResourceManager::Get().Update();
+    }, FrameGraph::Affinity::MainThread);
+    Game::Get().BuildFrameGraph(frameGraph);
+    // Overlapping frames needs workers, and adds a frame of latency.
+    frameGraph.SetFramesInFlight(JobSystem::Get().GetThreadCount() && !FramePacer::Get().IsLowLatency() ? 2 : 1);
+    if(dump_frame_graph)
+        SDL_Log("%s", frameGraph.Dump().c_str());
+#ifdef ISKER_HOT_RELOAD
+    ResourceManager::Get().EnableHotReload(ISKER_ASSET_SOURCE_DIR);
+#endif
 
 #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(gameLoop, 0, true);
@@ -93,8 +255,27 @@ int main(int argc, char* argv[])
     while(bRunning) { gameLoop(); }
 #endif
 
+    frameGraph.Flush();
+    Simulation::Get().Stop();
+    AllocationTracker::Get().SetSteadyState(false);
+    AllocationTracker::Get().LogReport();
+
+    int result = 0;
+    if(Replay::Get().IsPlaying())
+    {
+        const Replay::FrameStats stats = Replay::Get().GetFrameStats();
+        SDL_Log("Replay: %u frames, %.2f ms mean, %.2f ms 95th percentile, %.2f ms worst\n", stats.frames, stats.mean, stats.p95, stats.max);
+        if(save_baseline_path)
+            Replay::Get().SaveBaseline(save_baseline_path);
+        if(baseline_path && !Replay::Get().CompareBaseline(baseline_path))
+            result = 1;
+    }
+    Replay::Get().Finish();
+    ResourceManager::Get().Clear();
+    JobSystem::Get().Shutdown();
+
     SDL_DestroyWindow(pWindow);
     SDL_Quit();
 
-    return 0;
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Resource/CookedTextureFormat.hpp"
+
+namespace fs = std::filesystem;
+
+struct CookOptions
+{
+    bool premultiply = false;
+    bool mips = true;
+};
+
+struct Image
+{
+    uint32_t width, height;
+    std::vector<unsigned char> pixels;
+};
+
+static void Premultiply(Image &image)
+{
+    for(size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        unsigned int a = image.pixels[i + 3];
+        for(int c = 0; c < 3; c++)
+            image.pixels[i + c] = (unsigned char)((image.pixels[i + c] * a + 127) / 255);
+    }
+}
+
+static void Unpremultiply(Image &image)
+{
+    for(size_t i = 0; i < image.pixels.size(); i += 4)
+    {
+        unsigned int a = image.pixels[i + 3];
+        if(!a) continue;
+        for(int c = 0; c < 3; c++)
+            image.pixels[i + c] = (unsigned char)std::min(255u, (image.pixels[i + c] * 255 + a / 2) / a);
+    }
+}
+
+// 2x2 box filter. Expects premultiplied input so transparent texels don't bleed colour.
+static Image Downsample(const Image &source)
+{
+    Image result;
+    result.width = std::max(1u, source.width / 2);
+    result.height = std::max(1u, source.height / 2);
+    result.pixels.resize((size_t)result.width * result.height * 4);
+
+    for(uint32_t y = 0; y < result.height; y++)
+    {
+        for(uint32_t x = 0; x < result.width; x++)
+        {
+            uint32_t x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+            uint32_t y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+            for(int c = 0; c < 4; c++)
+            {
+                unsigned int sum = source.pixels[((size_t)y0 * source.width + x0) * 4 + c]
+                                 + source.pixels[((size_t)y0 * source.width + x1) * 4 + c]
+                                 + source.pixels[((size_t)y1 * source.width + x0) * 4 + c]
+                                 + source.pixels[((size_t)y1 * source.width + x1) * 4 + c];
+                result.pixels[((size_t)y * result.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+static bool Cook(const fs::path &input, const fs::path &output, const CookOptions &options)
+{
+    // Flip at cook time so the engine never has to.
+    stbi_set_flip_vertically_on_load(1);
+    int w, h, c;
+    unsigned char *data = stbi_load(input.string().c_str(), &w, &h, &c, 4);
+    if(!data)
+    {
+        fprintf(stderr, "Cannot load image file %s\nSTB Reason: %s\n", input.string().c_str(), stbi_failure_reason());
+        return false;
+    }
+
+    Image image{ (uint32_t)w, (uint32_t)h, std::vector<unsigned char>(data, data + (size_t)w * h * 4) };
+    stbi_image_free(data);
+
+    // Mips are filtered from a premultiplied copy. Straight-alpha output
+    // keeps level 0 exactly as loaded and only converts the filtered levels
+    // back, so the base image neither loses precision nor has the colour of
+    // its transparent texels zeroed.
+    Image working = image;
+    Premultiply(working);
+
+    std::vector<Image> levels;
+    levels.push_back(options.premultiply ? working : image);
+    while(options.mips && levels.size() < COOKED_TEXTURE_MAX_LEVELS && (levels.back().width > 1 || levels.back().height > 1))
+    {
+        working = Downsample(working);
+        levels.push_back(working);
+        if(!options.premultiply)
+            Unpremultiply(levels.back());
+    }
+
+    CookedTextureHeader header = {};
+    header.magic = COOKED_TEXTURE_MAGIC;
+    header.version = COOKED_TEXTURE_VERSION;
+    header.width = image.width;
+    header.height = image.height;
+    header.channels = (uint32_t)c;
+    header.flags = (uint32_t)COOKEDTEXTUREFLAG_FLIPPED | (options.premultiply ? (uint32_t)COOKEDTEXTUREFLAG_PREMULTIPLIED : 0u);
+    header.levelCount = (uint32_t)levels.size();
+
+    uint32_t offset = sizeof(CookedTextureHeader);
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        offset = (offset + COOKED_TEXTURE_ALIGNMENT - 1) / COOKED_TEXTURE_ALIGNMENT * COOKED_TEXTURE_ALIGNMENT;
+        header.levels[i] = CookedTextureLevel{ offset, (uint32_t)levels[i].pixels.size(), levels[i].width, levels[i].height };
+        offset += (uint32_t)levels[i].pixels.size();
+    }
+
+    std::error_code error;
+    if(output.has_parent_path())
+        fs::create_directories(output.parent_path(), error);
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if(!out)
+    {
+        fprintf(stderr, "Cannot open %s for writing\n", output.string().c_str());
+        return false;
+    }
+    out.write((const char *)&header, sizeof(header));
+    for(size_t i = 0; i < levels.size(); i++)
+    {
+        static const char zeros[COOKED_TEXTURE_ALIGNMENT] = { 0 };
+        out.write(zeros, header.levels[i].offset - (uint32_t)out.tellp());
+        out.write((const char *)levels[i].pixels.data(), levels[i].pixels.size());
+    }
+    return (bool)out;
+}
+
+static bool IsImage(const fs::path &path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: isker-cook [--premultiply] [--no-mips] <input> <output>\n"
+                    "Input may be an image file or a directory, in which case every image under it\n"
+                    "is cooked into the same relative path under output with a %s extension.\n", COOKED_TEXTURE_EXTENSION);
+}
+
+int main(int argc, char* argv[])
+{
+    CookOptions options;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--premultiply")) options.premultiply = true;
+        else if(!strcmp(argv[i], "--no-mips")) options.mips = false;
+        else args.push_back(argv[i]);
+    }
+    if(args.size() != 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const fs::path input = args[0];
+    const fs::path output = args[1];
+
+    if(!fs::is_directory(input))
+        return Cook(input, output, options) ? 0 : 1;
+
+    int cooked = 0, failed = 0;
+    for(const auto &entry : fs::recursive_directory_iterator(input))
+    {
+        if(!entry.is_regular_file() || !IsImage(entry.path())) continue;
+        fs::path target = output / fs::relative(entry.path(), input);
+        target.replace_extension(COOKED_TEXTURE_EXTENSION);
+        if(Cook(entry.path(), target, options)) cooked++;
+        else failed++;
+    }
+    printf("Cooked %d textures into %s\n", cooked, output.string().c_str());
+    return failed ? 1 : 0;
+}
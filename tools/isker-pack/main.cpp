@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Resource/AssetPackFormat.hpp"
+#include "Resource/Hash.hpp"
+#include "Resource/LZ4.hpp"
+
+namespace fs = std::filesystem;
+
+// Only keep the compressed copy when it saves at least this much.
+static constexpr double MIN_COMPRESSION_SAVING = 0.1;
+
+struct PackFile
+{
+    std::string path;
+    fs::path source;
+};
+
+static bool ReadFile(const fs::path &path, std::vector<unsigned char> &data)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if(!stream) return false;
+    data.resize((size_t)stream.tellg());
+    stream.seekg(0);
+    stream.read((char *)data.data(), data.size());
+    return true;
+}
+
+static void PadTo(std::ofstream &out, uint64_t alignment)
+{
+    static const char zeros[ASSET_PACK_ALIGNMENT] = { 0 };
+    uint64_t pos = (uint64_t)out.tellp();
+    uint64_t padding = (alignment - pos % alignment) % alignment;
+    out.write(zeros, padding);
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: isker-pack [--lz4] [--no-compress <extension>]... <output> <root> <directory> [<root> <directory>]...\n"
+                    "Packs every file under each directory, keyed by its path relative to the root before it.\n"
+                    "Files with a --no-compress extension are always stored so they can be used straight from the mapping.\n");
+}
+
+int main(int argc, char* argv[])
+{
+    bool compress = false;
+    std::vector<std::string> uncompressed_extensions;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "--lz4")) compress = true;
+        else if(!strcmp(argv[i], "--no-compress") && i + 1 < argc) uncompressed_extensions.push_back(argv[++i]);
+        else args.push_back(argv[i]);
+    }
+    if(args.size() < 3 || args.size() % 2 != 1)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const fs::path output = args[0];
+
+    std::vector<PackFile> files;
+    for(size_t i = 1; i < args.size(); i += 2)
+    {
+        const fs::path root = args[i];
+        const std::string &directory = args[i + 1];
+        std::error_code error;
+        for(auto it = fs::recursive_directory_iterator(directory, error); it != fs::recursive_directory_iterator(); it.increment(error))
+        {
+            if(error) break;
+            if(!it->is_regular_file()) continue;
+            files.push_back(PackFile{ fs::relative(it->path(), root).generic_string(), it->path() });
+        }
+        if(error)
+        {
+            fprintf(stderr, "Cannot read directory %s: %s\n", directory.c_str(), error.message().c_str());
+            return 1;
+        }
+    }
+    // Sorted input keeps the pack byte-identical across runs.
+    std::sort(files.begin(), files.end(), [](const PackFile &a, const PackFile &b) { return a.path < b.path; });
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if(!out)
+    {
+        fprintf(stderr, "Cannot open %s for writing\n", output.string().c_str());
+        return 1;
+    }
+
+    AssetPackHeader header = {};
+    out.write((const char *)&header, sizeof(header));
+
+    std::vector<AssetPackEntry> entries;
+    std::string strings;
+    std::vector<unsigned char> data, compressed;
+    std::unordered_map<uint64_t, AssetPackEntry> written;
+    uint64_t total_size = 0, total_stored = 0;
+
+    for(const PackFile &file : files)
+    {
+        if(!ReadFile(file.source, data))
+        {
+            fprintf(stderr, "Cannot read %s\n", file.source.string().c_str());
+            return 1;
+        }
+
+        AssetPackEntry entry = {};
+        entry.pathHash = HashBytes(file.path.data(), file.path.length());
+        entry.pathOffset = (uint32_t)strings.length();
+        entry.pathLength = (uint32_t)file.path.length();
+        entry.size = data.size();
+        entry.contentHash = HashBytes(data.data(), data.size());
+        strings += file.path;
+
+        auto duplicate = written.find(entry.contentHash);
+        if(duplicate != written.end() && duplicate->second.size == entry.size)
+        {
+            entry.offset = duplicate->second.offset;
+            entry.storedSize = duplicate->second.storedSize;
+            entry.flags = duplicate->second.flags;
+            entries.push_back(entry);
+            total_size += entry.size;
+            continue;
+        }
+
+        const unsigned char *stored = data.data();
+        size_t stored_size = data.size();
+        bool may_compress = std::find(uncompressed_extensions.begin(), uncompressed_extensions.end(), file.source.extension().string()) == uncompressed_extensions.end();
+        if(compress && may_compress && !data.empty())
+        {
+            compressed.resize(LZ4::CompressBound((int)data.size()));
+            int compressed_size = LZ4::Compress(data.data(), (int)data.size(), compressed.data(), (int)compressed.size());
+            if(compressed_size > 0 && compressed_size <= data.size() * (1.0 - MIN_COMPRESSION_SAVING))
+            {
+                stored = compressed.data();
+                stored_size = compressed_size;
+                entry.flags |= ASSETPACKFLAG_LZ4;
+            }
+        }
+
+        PadTo(out, ASSET_PACK_ALIGNMENT);
+        entry.offset = (uint64_t)out.tellp();
+        entry.storedSize = stored_size;
+        out.write((const char *)stored, stored_size);
+        entries.push_back(entry);
+        written[entry.contentHash] = entry;
+
+        total_size += entry.size;
+        total_stored += entry.storedSize;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const AssetPackEntry &a, const AssetPackEntry &b) { return a.pathHash < b.pathHash; });
+
+    PadTo(out, ASSET_PACK_ALIGNMENT);
+    header.tocOffset = (uint64_t)out.tellp();
+    out.write((const char *)entries.data(), entries.size() * sizeof(AssetPackEntry));
+    header.stringTableOffset = (uint64_t)out.tellp();
+    out.write(strings.data(), strings.length());
+
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = (uint32_t)entries.size();
+    header.stringTableSize = (uint32_t)strings.length();
+    out.seekp(0);
+    out.write((const char *)&header, sizeof(header));
+
+    if(!out)
+    {
+        fprintf(stderr, "Failed writing %s\n", output.string().c_str());
+        return 1;
+    }
+
+    printf("Packed %zu files into %s (%llu -> %llu bytes)\n", entries.size(), output.string().c_str(),
+        (unsigned long long)total_size, (unsigned long long)total_stored);
+    return 0;
+}